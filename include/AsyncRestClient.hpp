@@ -0,0 +1,62 @@
+// AsyncRestClient.hpp
+
+#ifndef ASYNCRESTCLIENT_HPP
+#define ASYNCRESTCLIENT_HPP
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <curl/curl.h>
+
+// Non-blocking JSON-RPC POSTs to one endpoint, driven by a curl multi handle on
+// a single background thread. Requests are multiplexed as HTTP/2 streams over
+// one connection when the server supports it (new requests wait for that
+// connection rather than opening another); otherwise curl falls back to a few
+// parallel HTTP/1.1 connections.
+class AsyncRestClient {
+public:
+    // result is CURLE_OPERATION_TIMEDOUT past the timeout and another error code on
+    // transport errors; runs on the client thread, so it must not block
+    typedef std::function<void(CURLcode result, const std::string& response)> Callback;
+
+    // timeout_ms bounds each request from submission to the last response byte
+    AsyncRestClient(const std::string& url, long max_connections, long timeout_ms);
+    ~AsyncRestClient();
+
+    // Thread-safe; auth_token may be empty
+    void post(std::string body, const std::string& auth_token, Callback callback);
+
+    size_t in_flight() const;
+
+private:
+    struct Request {
+        CURL* curl = nullptr;
+        curl_slist* headers = nullptr;
+        std::string body;
+        std::string response;
+        Callback callback;
+    };
+
+    void run();
+    void start_request(Request* request);
+    void finish_request(Request* request, CURLcode result);
+    CURL* acquire_handle();
+
+    std::string url_;
+    long timeout_ms_;
+    CURLM* multi_;
+    std::vector<CURL*> idle_handles_; // Client thread only; reused so options are set once
+    std::unordered_set<Request*> active_; // Client thread only
+
+    std::vector<Request*> submitted_;
+    mutable std::mutex submit_mtx_;
+    size_t in_flight_; // Guarded by submit_mtx_
+
+    bool running_;     // Guarded by submit_mtx_
+    std::thread thread_;
+};
+
+#endif // ASYNCRESTCLIENT_HPP
@@ -0,0 +1,78 @@
+// BinaryEncoder.hpp
+
+#ifndef BINARYENCODER_HPP
+#define BINARYENCODER_HPP
+
+#include "InstrumentRegistry.hpp"
+#include <cstdint>
+#include <string_view>
+
+// Compact binary form of market data notifications for downstream clients that
+// subscribe with "encoding": "binary". Every message is one Header followed by
+// header.count fixed-size records of the header's type, all little-endian with
+// the layout of the structs below (no padding beyond what they declare).
+// Instruments are identified by the InstrumentId returned in the subscribe
+// acknowledgement. Doubles that the exchange did not send are NaN.
+class BinaryEncoder {
+public:
+    enum MessageType : uint8_t {
+        Book = 1,   // BookHeader, then count BookLevel
+        Trades = 2, // count TradeRecord, oldest first
+        Ticker = 3  // One TickerRecord (ticker and quote channels)
+    };
+    enum Flags : uint8_t { Snapshot = 1 }; // Book only: levels replace the whole book
+
+    struct Header {
+        uint8_t type;
+        uint8_t flags;
+        uint16_t reserved;
+        uint32_t instrument;
+        uint32_t count;
+        uint32_t reserved2;
+    };
+
+    struct BookHeader {
+        uint64_t change_id;
+        uint64_t prev_change_id; // 0 for snapshots
+    };
+
+    struct BookLevel {
+        double price;
+        double amount;
+        uint8_t side;   // 0 bid, 1 ask
+        uint8_t action; // 0 new, 1 change, 2 delete
+        uint8_t padding[6];
+    };
+
+    struct TradeRecord {
+        uint64_t trade_seq;
+        uint64_t timestamp_ms;
+        double price;
+        double amount;
+        uint8_t is_buy;
+        uint8_t padding[7];
+    };
+
+    struct TickerRecord {
+        uint64_t timestamp_ms;
+        double best_bid_price;
+        double best_bid_amount;
+        double best_ask_price;
+        double best_ask_amount;
+        double last_price;
+        double mark_price;
+        double index_price;
+    };
+
+    // Encodes params.data of a notification on a channel of the given type into a
+    // thread-local buffer, valid until the next call on the same thread. Empty if
+    // the channel type has no binary form or the payload does not decode.
+    static std::string_view encode(ChannelType type, InstrumentId instrument, std::string_view data);
+
+private:
+    static bool encode_book(InstrumentId instrument, std::string_view data, std::string& out);
+    static bool encode_trades(InstrumentId instrument, std::string_view data, std::string& out);
+    static bool encode_ticker(InstrumentId instrument, std::string_view data, std::string& out);
+};
+
+#endif // BINARYENCODER_HPP
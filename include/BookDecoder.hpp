@@ -0,0 +1,82 @@
+// BookDecoder.hpp
+
+#ifndef BOOKDECODER_HPP
+#define BOOKDECODER_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Structure-of-arrays level buffer filled straight from the payload
+struct LevelBuffer {
+    enum Action : uint8_t { New = 0, Change = 1, Delete = 2 };
+
+    std::vector<uint8_t> actions;
+    std::vector<double> prices;
+    std::vector<double> amounts;
+
+    void clear() {
+        actions.clear();
+        prices.clear();
+        amounts.clear();
+    }
+    size_t size() const { return prices.size(); }
+};
+
+// Decoded book.<instrument>.<interval> notification
+struct BookUpdate {
+    bool is_snapshot = false;
+    bool has_prev_change_id = false;
+    uint64_t change_id = 0;
+    uint64_t prev_change_id = 0;
+    LevelBuffer bids;
+    LevelBuffer asks;
+};
+
+// Decoded trades.<instrument>.<interval> notification (SoA)
+struct TradeBuffer {
+    std::vector<double> prices;
+    std::vector<double> amounts;
+    std::vector<uint8_t> is_buy;
+    std::vector<uint64_t> trade_seqs;
+    std::vector<uint64_t> timestamps;
+
+    void clear() {
+        prices.clear();
+        amounts.clear();
+        is_buy.clear();
+        trade_seqs.clear();
+        timestamps.clear();
+    }
+    size_t size() const { return prices.size(); }
+};
+
+// Specialized decoder for the book and trades payloads.
+// Numbers are converted with the same correctly rounded result nlohmann::json
+// produces (exact fast path, std::from_chars otherwise), so the doubles are
+// bit-identical to the generic parse. Digit scanning and mantissa conversion use
+// AVX2/SSE4.1 when the CPU supports them and a scalar loop otherwise.
+// Returns false on any unexpected shape; callers then fall back to
+// decode_book_generic, which goes through nlohmann.
+class BookDecoder {
+public:
+    // data is the raw params.data object / array; buffers are cleared first
+    static bool decode_book(std::string_view data, BookUpdate& update);
+    static bool decode_trades(std::string_view data, TradeBuffer& trades);
+    // Same result as decode_book for any payload it accepts, but slower; false
+    // only if the payload is not JSON or the levels are malformed
+    static bool decode_book_generic(std::string_view data, BookUpdate& update);
+
+    // True if the AVX2 path is in use; it is selected at startup when the CPU supports it
+    static bool simd_enabled();
+    // Force the scalar path (false) or return to AVX2 where supported (true), e.g. to compare the two
+    static void set_simd_enabled(bool enabled);
+
+private:
+    static bool decode_levels(std::string_view data, size_t& pos, LevelBuffer& levels);
+    static bool decode_trade(std::string_view data, size_t& pos, TradeBuffer& trades);
+    static bool parse_double(std::string_view data, size_t& pos, double& value);
+    static bool parse_uint(std::string_view data, size_t& pos, uint64_t& value);
+};
+
+#endif // BOOKDECODER_HPP
@@ -2,6 +2,7 @@
 #define CONFIG_HPP
 
 #include <string>
+#include <unordered_map>
 
 struct Config {
     std::string api_key;
@@ -10,6 +11,35 @@ struct Config {
     std::string rest_url;
     int websocket_port;
     std::string log_file;
+    size_t market_data_queue_capacity; // Optional, defaults to 65536
+    bool market_data_conflation;        // Optional, defaults to false
+    size_t market_data_workers;         // Optional, defaults to 0 (process on the dispatcher thread)
+    size_t ws_connections;              // Optional, upstream market data sessions, defaults to 1
+    std::string ws_shard_policy;        // Optional, "hash" (default) or "explicit"
+    std::unordered_map<std::string, size_t> ws_shard_assignments; // Optional, instrument -> session
+    int ws_heartbeat_interval;          // Optional, seconds, defaults to 10
+    int ws_idle_probe_ms;               // Optional, defaults to 500
+    int ws_idle_timeout_ms;             // Optional, defaults to 1500
+    int ws_reconnect_min_ms;            // Optional, defaults to 50
+    int ws_reconnect_max_ms;            // Optional, defaults to 5000
+    int ws_request_timeout_ms;          // Optional, defaults to 5000
+    size_t rest_connections;            // Optional, defaults to 2
+    int rest_keepalive_ping_ms;         // Optional, defaults to 15000 (0 disables)
+    long rest_async_max_connections;    // Optional, defaults to 4
+    double rate_limit_matching_per_s;   // Optional, defaults to 5
+    double rate_limit_matching_burst;   // Optional, defaults to 20
+    double rate_limit_non_matching_per_s; // Optional, defaults to 20
+    double rate_limit_non_matching_burst; // Optional, defaults to 100
+    double rate_limit_cancel_reserve;   // Optional, defaults to 2
+    int rate_limit_max_queue_ms;        // Optional, defaults to 500
+    std::string order_journal_file;     // Optional, defaults to "order_journal.bin" ("" disables)
+    size_t order_journal_capacity;      // Optional, records, defaults to 65536
+    int position_reconcile_interval_s;  // Optional, defaults to 60 (0 disables)
+    size_t websocket_io_threads;        // Optional, downstream server io threads, defaults to 1
+    size_t websocket_send_high_water_bytes; // Optional, defaults to 1048576
+    size_t websocket_send_queue_limit;  // Optional, messages per client, defaults to 1024
+    std::string websocket_slow_consumer_policy; // Optional, "drop_oldest" (default), "conflate" or "disconnect"
+    bool websocket_permessage_deflate;  // Optional, defaults to true
     
     static Config load(const std::string& config_file);
 };
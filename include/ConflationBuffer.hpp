@@ -0,0 +1,41 @@
+// ConflationBuffer.hpp
+
+#ifndef CONFLATIONBUFFER_HPP
+#define CONFLATIONBUFFER_HPP
+
+#include "InstrumentRegistry.hpp"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Latest-value store for state-like channels.
+// Holds one slot per channel id with a dirty flag; a burst of updates to the same
+// channel overwrites the slot and is delivered once when the consumer drains.
+// Not thread-safe: owned and drained by the dispatcher's consumer thread.
+class ConflationBuffer {
+public:
+    typedef std::function<void(ChannelId, std::string_view)> DrainCallback;
+
+    void update(ChannelId channel, std::string_view data);
+
+    // Deliver every dirty slot, in the order the slots first became dirty
+    void drain(const DrainCallback& callback);
+
+    bool empty() const { return dirty_slots_.empty(); }
+    uint64_t conflated_count() const { return conflated_; }
+
+private:
+    struct Slot {
+        std::string data;
+        bool dirty = false;
+    };
+
+    std::vector<Slot> slots_; // Indexed by ChannelId
+    std::vector<ChannelId> dirty_slots_;
+    std::vector<ChannelId> draining_; // Swapped with dirty_slots_ so neither reallocates
+    uint64_t conflated_ = 0;
+};
+
+#endif // CONFLATIONBUFFER_HPP
@@ -4,57 +4,229 @@
 #define DERIBITAPI_HPP
 
 #include <string>
+#include <string_view>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <unordered_map>
 #include <unordered_set>
 #include <functional>
+#include <future>
+#include <condition_variable>
+#include "MarketDataDispatcher.hpp"
+#include "RestConnectionPool.hpp"
+#include "AsyncRestClient.hpp"
+#include "RpcAwaitable.hpp"
+#include "RateLimiter.hpp"
 #include <nlohmann/json.hpp>
 #include <websocketpp/config/asio_client.hpp>
 #include <websocketpp/client.hpp>
 #include <boost/asio/ssl/context.hpp>
+#include <openssl/ssl.h>
 
 // Forward declaration for WebSocket++ types
 typedef websocketpp::connection_hdl connection_hdl;
 
+// How channels are spread across upstream WebSocket sessions
+enum class ShardPolicy {
+    Hash,     // Hash of the channel's instrument
+    Explicit  // shard_assignments by instrument, hash for anything unlisted
+};
+
+// Market data connection settings
+struct DeribitOptions {
+    size_t market_data_queue_capacity = 65536;
+    bool market_data_conflation = false;
+    size_t market_data_workers = 0; // Callback threads, sharded by instrument; 0 runs it on the dispatcher thread
+    size_t ws_connections = 1;
+    ShardPolicy shard_policy = ShardPolicy::Hash;
+    std::unordered_map<std::string, size_t> shard_assignments; // Instrument -> session index
+
+    // Link liveness and reconnect
+    int heartbeat_interval_s = 10;   // public/set_heartbeat interval (exchange minimum is 10)
+    int idle_probe_ms = 500;         // Send public/test after this long without a frame
+    int idle_timeout_ms = 1500;      // Drop the connection after this long without a frame
+    int reconnect_min_ms = 50;       // First reconnect delay; doubles per failed attempt
+    int reconnect_max_ms = 5000;
+    int request_timeout_ms = 5000;   // Fail a WebSocket or async REST request with no response after this long
+
+    // REST connections kept open and warm for send_request
+    size_t rest_connections = 2;
+    int rest_keepalive_ping_ms = 15000; // Ping a connection idle this long; 0 disables
+    long rest_async_max_connections = 4; // Async REST engine; one suffices when HTTP/2 multiplexes
+
+    // Client-side rate limits, in requests; defaults match the standard account tier
+    double matching_engine_rate = 5.0;   // buy/sell/edit/cancel per second
+    double matching_engine_burst = 20.0;
+    double non_matching_rate = 20.0;     // 10000 credits per second at 500 per request
+    double non_matching_burst = 100.0;   // 50000 credits
+    double cancel_reserve = 2.0;         // Matching engine credits new orders may not use
+    int rate_limit_max_queue_ms = 500;   // Shed requests that would wait longer than this
+};
+
 class DeribitAPI {
 public:
     // Type definitions
-    typedef std::function<void(const std::string&, const std::string&)> MessageCallback;
+    // Interned channel id and raw JSON of params.data; the view is only valid during the call
+    typedef MarketDataDispatcher::MessageCallback MessageCallback;
     typedef websocketpp::client<websocketpp::config::asio_tls_client> WsClient;
     typedef websocketpp::client<websocketpp::config::asio_tls_client>::message_ptr message_ptr;
+    // Receives the full JSON-RPC response (result or error) for a WebSocket request
+    typedef std::function<void(const nlohmann::json&)> RpcCallback;
 
     // Constructor and Destructor
     DeribitAPI(const std::string& api_key, const std::string& api_secret,
-               const std::string& rest_url, const std::string& websocket_url);
+               const std::string& rest_url, const std::string& websocket_url,
+               const DeribitOptions& options = DeribitOptions());
     ~DeribitAPI();
 
     // Public methods
+    // With market_data_workers > 0 the callback runs concurrently for different
+    // instruments; updates for one instrument always arrive in order on one thread
     void set_message_callback(MessageCallback callback);
+    // Receives user.* notifications (own orders, trades, positions) instead of the
+    // message callback; always runs on the dispatcher thread, in arrival order.
+    // Every added callback sees every user notification.
+    void add_user_callback(MessageCallback callback);
+
+    // Single-channel helpers block until the exchange answers or request_timeout_ms
+    // passes, so they must not be called from the message callback
     bool subscribe(const std::string& channel);
     bool unsubscribe(const std::string& channel);
     bool unsubscribe_all();
 
+    // Private channels go out as private/subscribe on the order session once it is
+    // authenticated, and again after every reconnect
+    void subscribe_private(const std::vector<std::string>& channels);
+
+    // Batched requests: one JSON-RPC call per session. The future is always
+    // completed, at the latest when a request times out, and yields the
+    // channels the exchange actually accepted (or removed).
+    std::future<std::vector<std::string>> subscribe(const std::vector<std::string>& channels);
+    std::future<std::vector<std::string>> unsubscribe(const std::vector<std::string>& channels);
+
+    // Receive queue depth and drop counters
+    MarketDataDispatcher::Stats get_market_data_stats() const;
+    RateLimiter::Stats get_rate_limit_stats() const;
+
     // Order Management Methods
+    // Orders go over the authenticated WebSocket session when it is up and fall back
+    // to REST otherwise. A request that was sent but lost with its connection is
+    // reported as an error, never retried, since it may already have been executed;
+    // so is one with no answer within request_timeout_ms.
+    // Requests pass the client-side rate limiter first: cancels go ahead of new
+    // orders, and a request shed locally fails with error code 10028 like an
+    // exchange too_many_requests.
     nlohmann::json place_order(const std::string& instrument, const std::string& side, double quantity, double price);
     nlohmann::json cancel_order(const std::string& order_id);
     nlohmann::json modify_order(const std::string& order_id, double new_quantity, double new_price);
 
+    std::future<nlohmann::json> place_order_async(const std::string& instrument, const std::string& side, double quantity, double price);
+    std::future<nlohmann::json> cancel_order_async(const std::string& order_id);
+    std::future<nlohmann::json> modify_order_async(const std::string& order_id, double new_quantity, double new_price);
+
+    // Callback forms; the callback runs on the dispatcher or async REST thread
+    void place_order_async(const std::string& instrument, const std::string& side, double quantity, double price, RpcCallback callback);
+    void cancel_order_async(const std::string& order_id, RpcCallback callback);
+    void modify_order_async(const std::string& order_id, double new_quantity, double new_price, RpcCallback callback);
+
+    // Mass cancel: private/cancel_all and private/cancel_all_by_instrument; the
+    // result is the number of orders cancelled
+    nlohmann::json cancel_all();
+    nlohmann::json cancel_all_by_instrument(const std::string& instrument);
+    std::future<nlohmann::json> cancel_all_async();
+    std::future<nlohmann::json> cancel_all_by_instrument_async(const std::string& instrument);
+
+    RpcAwaitable place_order_awaitable(const std::string& instrument, const std::string& side, double quantity, double price);
+    RpcAwaitable cancel_order_awaitable(const std::string& order_id);
+    RpcAwaitable modify_order_awaitable(const std::string& order_id, double new_quantity, double new_price);
+
+    // True once the order session has completed public/auth
+    bool is_ws_authenticated() const;
+
     // Data Retrieval Methods
-    nlohmann::json get_orderbook(const std::string& instrument);
+    nlohmann::json get_orderbook(const std::string& instrument, int depth = 0);
     nlohmann::json get_positions();
+    nlohmann::json get_open_orders();
     nlohmann::json get_market_data(const std::string& symbol);
 
+    // Non-blocking REST call; the callback gets the JSON-RPC response (or an error
+    // object) on the async REST thread and must not block
+    void send_request_async(const std::string& method, const nlohmann::json& params, bool requires_auth, RpcCallback callback);
+
     // Authentication Method
+    // Blocking client_credentials login; call once at startup. After that the
+    // background refresher renews the token, and requests never authenticate inline.
     bool authenticate();
 
 private:
+    // One upstream WebSocket connection with its own io thread
+    struct WsSession {
+        size_t index;
+        bool connected = false;
+        connection_hdl hdl;
+        WsClient client;
+        std::thread thread;
+        std::mutex mtx; // Guards connected and hdl
+        std::unordered_set<std::string> channels; // Accepted by the exchange; guarded by subscription_mtx_
+
+        // Liveness; last_rx_ns is a steady_clock timestamp written by the io thread
+        std::atomic<int64_t> last_rx_ns{0};
+        std::atomic<bool> probe_outstanding{false};
+        std::atomic<bool> opened{false};
+        std::atomic<bool> authenticated{false}; // public/auth accepted on this connection
+        std::string refresh_token;                  // Connection's auth; guarded by mtx
+        std::chrono::steady_clock::time_point auth_refresh_at;
+        WsClient::timer_ptr watchdog;   // io thread only
+        SSL_SESSION* tls_session = nullptr; // io thread only; offered on the next handshake
+    };
+
+    // Published by authenticate() and the refresher, read lock-free by request paths
+    struct TokenSnapshot {
+        std::string access_token;
+        std::string refresh_token;
+        std::chrono::system_clock::time_point expiry;
+        std::chrono::system_clock::time_point refresh_at;
+    };
+
+    struct PendingRequest {
+        size_t session;
+        int64_t deadline_ns; // steady clock; failed with a timeout error after this
+        RpcCallback callback;
+    };
+
     // Private methods
-    void init_deribit_connection();
+    void init_deribit_connection(WsSession& session);
+    WsSession& session_for(const std::string& channel);
+    bool send_ws(WsSession& session, std::string_view message);
+    bool send_rpc(WsSession& session, const std::string& method, const nlohmann::json& params, RpcCallback callback);
+    bool send_rpc_encoded(WsSession& session, uint64_t id, std::string_view message, RpcCallback callback);
+    void post_async(std::string body, bool requires_auth, RpcCallback callback);
+    void fail_pending_requests(size_t session, const std::string& reason, bool expired_only = false);
+    void authenticate_ws(WsSession& session);
+    void on_ws_auth_response(WsSession& session, const nlohmann::json& response);
+    void send_private_subscribe(WsSession& session, const std::vector<std::string>& channels);
+    bool request_token(const nlohmann::json& auth_params);
+    void run_token_refresh();
+    void submit_order(const std::string& method, const nlohmann::json& params, RpcCallback callback);
+    void submit_encoded_order(uint64_t id, std::string_view message, RateLimiter::Priority priority, RpcCallback callback);
+    void send_encoded_order(uint64_t id, std::string_view message, RpcCallback callback);
+    RpcCallback watch_throttle(RateLimiter::Pool pool, RpcCallback callback);
+    double tick_size_for(const std::string& instrument);
+    std::future<std::vector<std::string>> update_subscriptions(const std::vector<std::string>& channels, bool subscribe);
+    void init_tls_context();
     std::shared_ptr<boost::asio::ssl::context> on_tls_init(connection_hdl hdl);
-    void on_ws_open(connection_hdl hdl);
-    void on_ws_close(connection_hdl hdl);
-    void on_ws_fail(connection_hdl hdl);
-    void on_ws_message(connection_hdl hdl, message_ptr msg);
+    void on_socket_init(WsSession& session, connection_hdl hdl, boost::asio::ssl::stream<boost::asio::ip::tcp::socket>& stream);
+    void save_tls_session(WsSession& session, connection_hdl hdl);
+    void schedule_liveness_check(WsSession& session, connection_hdl hdl);
+    void check_liveness(WsSession& session, connection_hdl hdl, const websocketpp::lib::error_code& ec);
+    void on_ws_open(WsSession& session, connection_hdl hdl);
+    void on_ws_close(WsSession& session, connection_hdl hdl);
+    void on_ws_fail(WsSession& session, connection_hdl hdl);
+    void on_ws_message(WsSession& session, connection_hdl hdl, message_ptr msg);
+    void on_rpc_message(const std::string& payload);
     bool is_token_valid();
     nlohmann::json send_request(const std::string& method, const nlohmann::json& params, bool requires_auth);
 
@@ -63,17 +235,24 @@ private:
     std::string api_secret_;
     std::string rest_url_;
     std::string websocket_url_;
-    std::string access_token_;
-    std::chrono::system_clock::time_point token_expiry_;
-    bool ws_connected_;
-    connection_hdl ws_hdl_;
-    WsClient ws_client_;
-    std::thread ws_thread_;
-    std::mutex ws_mtx_;
+    std::atomic<std::shared_ptr<const TokenSnapshot>> token_;
+    DeribitOptions options_;
+    std::atomic<bool> running_;
+    std::vector<std::unique_ptr<WsSession>> sessions_;
+    std::shared_ptr<boost::asio::ssl::context> tls_ctx_; // Shared by every connection
+    std::unique_ptr<RestConnectionPool> rest_pool_;
+    std::unique_ptr<AsyncRestClient> async_rest_;
+    std::unique_ptr<RateLimiter> rate_limiter_;
     std::mutex subscription_mtx_;
-    std::mutex token_mtx_;
-    std::unordered_set<std::string> subscribed_channels_;
-    MessageCallback message_callback_;
+    std::unordered_set<std::string> private_channels_; // Guarded by subscription_mtx_
+    std::mutex auth_mtx_; // Serializes REST auth round trips
+    std::thread token_refresh_thread_;
+    std::mutex token_refresh_mtx_;
+    std::condition_variable token_refresh_cv_;
+    std::atomic<uint64_t> next_request_id_;
+    std::unordered_map<uint64_t, PendingRequest> pending_requests_;
+    std::mutex pending_mtx_;
+    MarketDataDispatcher dispatcher_;
 };
 
 #endif // DERIBITAPI_HPP
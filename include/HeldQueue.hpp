@@ -0,0 +1,93 @@
+// HeldQueue.hpp
+
+#ifndef HELDQUEUE_HPP
+#define HELDQUEUE_HPP
+
+#include "InstrumentRegistry.hpp"
+#include <cstddef>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+
+// What to do with a client whose held-back queue is full
+enum class SlowConsumerPolicy {
+    DropOldest, // Discard the oldest held-back message
+    Conflate,   // As DropOldest, but snapshot-type messages first replace the held one for their channel
+    Disconnect  // Close the connection
+};
+
+// Bounded queue of frames held back from a slow downstream client, oldest first.
+// Only frames that carry a full state (ticker, quote, snapshot books) may be
+// conflated: the newest one for a channel replaces the one already waiting, in
+// its place in the queue. Incremental book and trade frames are never replaced,
+// since the client needs every one of them. Not thread-safe.
+template <typename Frame>
+class HeldQueue {
+public:
+    enum class Result {
+        Queued,
+        Conflated,     // Replaced the waiting frame for the same channel
+        DroppedOldest, // Queued after discarding the oldest frame
+        Overflow       // Full under SlowConsumerPolicy::Disconnect; nothing was queued
+    };
+
+    HeldQueue(size_t limit, SlowConsumerPolicy policy) : limit_(limit > 0 ? limit : 1), policy_(policy) {}
+
+    // snapshot: the frame replaces, rather than adds to, the channel's earlier ones
+    Result push(ChannelId channel, bool snapshot, Frame frame) {
+        bool conflate = snapshot && policy_ == SlowConsumerPolicy::Conflate;
+        if (conflate) {
+            auto it = latest_.find(channel);
+            if (it != latest_.end()) {
+                it->second->frame = std::move(frame);
+                return Result::Conflated;
+            }
+        }
+
+        Result result = Result::Queued;
+        if (held_.size() >= limit_) {
+            if (policy_ == SlowConsumerPolicy::Disconnect) {
+                return Result::Overflow;
+            }
+            pop_front();
+            result = Result::DroppedOldest;
+        }
+
+        // References into a deque survive pushes and pops at either end
+        held_.push_back(Held{channel, std::move(frame)});
+        if (conflate) {
+            latest_[channel] = &held_.back();
+        }
+        return result;
+    }
+
+    bool empty() const { return held_.empty(); }
+    size_t size() const { return held_.size(); }
+    const Frame& front() const { return held_.front().frame; }
+
+    void pop_front() {
+        auto it = latest_.find(held_.front().channel);
+        if (it != latest_.end() && it->second == &held_.front()) {
+            latest_.erase(it);
+        }
+        held_.pop_front();
+    }
+
+    void clear() {
+        held_.clear();
+        latest_.clear();
+    }
+
+private:
+    struct Held {
+        ChannelId channel;
+        Frame frame;
+    };
+
+    size_t limit_;
+    SlowConsumerPolicy policy_;
+    std::deque<Held> held_;
+    std::unordered_map<ChannelId, Held*> latest_; // Conflated channels' entries in held_
+};
+
+#endif // HELDQUEUE_HPP
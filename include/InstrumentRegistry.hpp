@@ -0,0 +1,124 @@
+// InstrumentRegistry.hpp
+
+#ifndef INSTRUMENTREGISTRY_HPP
+#define INSTRUMENTREGISTRY_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+typedef uint32_t InstrumentId;
+typedef uint32_t ChannelId;
+
+static const uint32_t kInvalidId = UINT32_MAX;
+
+// Channel families the market data pipeline treats differently
+enum class ChannelType {
+    Book,         // book.<instrument>.<interval>, incremental
+    BookSnapshot, // book.<instrument>.<group>.<depth>.<interval>
+    Ticker,
+    Quote,
+    Trades,
+    User,
+    Other
+};
+
+// Ticker, quote and grouped book snapshot channels carry full state, so a newer
+// message may replace an unsent one; trades and incremental books must be
+// delivered in full
+inline bool is_snapshot_channel(ChannelType type) {
+    return type == ChannelType::Ticker || type == ChannelType::Quote || type == ChannelType::BookSnapshot;
+}
+
+// Process-wide registry assigning dense integer ids to channels and instruments.
+// Strings are interned at the edges (subscribe calls, client requests); the
+// market data hot path carries ids and resolves them by array index. Entries
+// are never removed, so an id stays valid for the lifetime of the process.
+class InstrumentRegistry {
+public:
+    static const size_t kMaxInstruments = 8192;
+    static const size_t kMaxChannels = 16384;
+
+    static InstrumentRegistry& getInstance();
+
+    // Called with each newly interned instrument, on the interning thread and
+    // outside the registry lock; pass an empty function to remove it
+    typedef std::function<void(InstrumentId)> InstrumentListener;
+    void set_instrument_listener(InstrumentListener listener);
+
+    // Return the existing id or assign the next one; kInvalidId when full
+    ChannelId intern_channel(std::string_view channel);
+    InstrumentId intern_instrument(std::string_view instrument);
+
+    // Lookup without assigning; kInvalidId if unknown
+    ChannelId find_channel(std::string_view channel) const;
+    InstrumentId find_instrument(std::string_view instrument) const;
+
+    // Id-indexed accessors; ids must come from this registry
+    const std::string& channel_name(ChannelId id) const { return channels_[id].name; }
+    InstrumentId channel_instrument(ChannelId id) const { return channels_[id].instrument; }
+    ChannelType channel_type(ChannelId id) const { return channels_[id].type; }
+    const std::string& instrument_name(InstrumentId id) const { return instruments_[id]; }
+
+    // Price increment from public/get_instrument; 0 until it has been loaded
+    double tick_size(InstrumentId id) const { return tick_sizes_[id].load(std::memory_order_acquire); }
+    void set_tick_size(InstrumentId id, double tick_size) { tick_sizes_[id].store(tick_size, std::memory_order_release); }
+    // Claims the fetch of an instrument's tick size; true for one caller only, and
+    // not again until a failed fetch's retry delay has passed
+    bool claim_tick_size_fetch(InstrumentId id);
+    // Gives up a claim whose fetch failed; the next claim succeeds after retry_after
+    void release_tick_size_fetch(InstrumentId id, std::chrono::steady_clock::duration retry_after);
+
+    size_t channel_count() const { return channel_count_.load(std::memory_order_acquire); }
+    size_t instrument_count() const { return instrument_count_.load(std::memory_order_acquire); }
+
+private:
+    InstrumentRegistry();
+    InstrumentRegistry(const InstrumentRegistry&) = delete;
+    InstrumentRegistry& operator=(const InstrumentRegistry&) = delete;
+
+    struct ChannelEntry {
+        std::string name;
+        InstrumentId instrument = kInvalidId;
+        ChannelType type = ChannelType::Other;
+    };
+
+    // Transparent hash so lookups by string_view do not allocate
+    struct StringHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>()(s); }
+    };
+    typedef std::unordered_map<std::string, uint32_t, StringHash, std::equal_to<>> IdMap;
+
+    static ChannelType classify(std::string_view channel);
+    static std::string_view channel_symbol(std::string_view channel);
+    ChannelId intern_channel_locked(std::string_view channel, InstrumentId& added);
+    // added is set to the id when the instrument is new
+    InstrumentId intern_instrument_locked(std::string_view instrument, InstrumentId& added);
+    void notify_added(InstrumentId added);
+
+    // Fixed-size tables: an entry is fully written before the count that covers it
+    // is published, so readers index them without taking the lock
+    std::unique_ptr<ChannelEntry[]> channels_;
+    std::unique_ptr<std::string[]> instruments_;
+    std::unique_ptr<std::atomic<double>[]> tick_sizes_;
+    // Steady clock time (ns) from which the tick size may be fetched; 0 before the
+    // first fetch, kTickSizeFetching while one is in flight
+    static const int64_t kTickSizeFetching = INT64_MAX;
+    std::unique_ptr<std::atomic<int64_t>[]> tick_size_retry_at_;
+    std::atomic<size_t> channel_count_;
+    std::atomic<size_t> instrument_count_;
+
+    IdMap channel_ids_;
+    IdMap instrument_ids_;
+    mutable std::shared_mutex mtx_;
+    std::atomic<std::shared_ptr<const InstrumentListener>> instrument_listener_;
+};
+
+#endif // INSTRUMENTREGISTRY_HPP
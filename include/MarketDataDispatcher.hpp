@@ -0,0 +1,105 @@
+// MarketDataDispatcher.hpp
+
+#ifndef MARKETDATADISPATCHER_HPP
+#define MARKETDATADISPATCHER_HPP
+
+#include "SpscQueue.hpp"
+#include "InstrumentRegistry.hpp"
+#include "ConflationBuffer.hpp"
+#include "MarketDataWorkerPool.hpp"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Decouples the WebSocket receive threads from parsing and fan-out.
+// Each receive thread only moves raw frames into its own bounded SPSC ring; a
+// dedicated consumer thread merges the rings round-robin, parses the frames and
+// invokes the callbacks. Frames from one ring are delivered in order. With conflation enabled,
+// state-like channels are collapsed to their latest value while the ring has a
+// backlog and delivered once it drains. With workers configured, the callback
+// runs on a MarketDataWorkerPool instead of the consumer thread; ordering is then
+// kept per instrument rather than per ring. JSON-RPC responses take a separate
+// unbounded queue that is never dropped and is served ahead of the rings, so a
+// burst of market data can neither lose nor delay a request's answer.
+class MarketDataDispatcher {
+public:
+    // Interned channel id and raw JSON of params.data
+    typedef std::function<void(ChannelId, std::string_view)> MessageCallback;
+    // Handler for frames that are not subscription notifications (RPC results, errors)
+    typedef std::function<void(const std::string&)> FrameHandler;
+
+    struct Stats {
+        size_t queue_depth;
+        size_t queue_capacity;
+        uint64_t enqueued;
+        uint64_t dropped;
+        uint64_t conflated; // Updates superseded by a newer one before delivery
+        size_t worker_backlog; // Notifications waiting in the worker pool
+    };
+
+    MarketDataDispatcher(size_t queue_count, size_t queue_capacity, FrameHandler frame_handler,
+                         bool conflation_enabled = false, size_t worker_count = 0);
+    ~MarketDataDispatcher();
+
+    void start();
+    void stop();
+
+    void set_message_callback(MessageCallback callback);
+    // User channels bypass conflation and the workers and go to every user
+    // callback on the consumer thread; callbacks can be added while running
+    void add_user_callback(MessageCallback callback);
+
+    // Called from the queue's receive thread only; drops the frame if the ring is full
+    bool enqueue(size_t queue, std::string&& frame);
+    // A response to a request; any thread, never dropped
+    void enqueue_response(std::string&& frame);
+
+    // Deliver an already parsed notification; called on the consumer thread
+    void dispatch(ChannelId channel, std::string_view data);
+    // Same, taking ownership of the frame that data points into
+    void dispatch(ChannelId channel, std::string&& frame, std::string_view data);
+
+    Stats get_stats() const;
+
+private:
+    void run();
+    void process(std::string& frame);
+    bool dispatch_user(ChannelId channel, std::string_view data);
+    void process_responses();
+    void flush_conflated();
+
+    std::vector<std::unique_ptr<SpscQueue<std::string>>> queues_;
+    std::mutex responses_mtx_;
+    std::deque<std::string> responses_; // Guarded by responses_mtx_
+    std::atomic<bool> responses_pending_;
+    FrameHandler frame_handler_;
+    MessageCallback message_callback_;
+    // Copied on add, so dispatch reads it without a lock
+    typedef std::vector<MessageCallback> UserCallbacks;
+    std::atomic<std::shared_ptr<const UserCallbacks>> user_callbacks_;
+    std::mutex user_callbacks_mtx_; // Serializes adds
+
+    // Only touched on the consumer thread
+    bool conflation_enabled_;
+    ConflationBuffer conflation_;
+    size_t frames_since_flush_;
+
+    // Null when the callback runs inline on the consumer thread
+    std::unique_ptr<MarketDataWorkerPool> workers_;
+
+    std::thread consumer_thread_;
+    std::atomic<bool> running_;
+    std::atomic<uint32_t> wake_seq_;
+    std::atomic<uint64_t> enqueued_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<uint64_t> conflated_;
+};
+
+#endif // MARKETDATADISPATCHER_HPP
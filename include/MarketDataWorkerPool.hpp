@@ -0,0 +1,64 @@
+// MarketDataWorkerPool.hpp
+
+#ifndef MARKETDATAWORKERPOOL_HPP
+#define MARKETDATAWORKERPOOL_HPP
+
+#include "SpscQueue.hpp"
+#include "InstrumentRegistry.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Runs the market data callback on a fixed set of threads.
+// Every instrument is pinned to one worker, so updates for an instrument are
+// delivered in order on a single thread while different instruments are processed
+// in parallel. Fed by the dispatcher thread through one SPSC ring per worker.
+class MarketDataWorkerPool {
+public:
+    typedef std::function<void(ChannelId, std::string_view)> MessageCallback;
+
+    MarketDataWorkerPool(size_t worker_count, size_t queue_capacity);
+    ~MarketDataWorkerPool();
+
+    void start();
+    void stop();
+
+    void set_message_callback(MessageCallback callback);
+
+    // Single producer. buffer[offset, offset + length) is the params.data text; the
+    // buffer is moved so the frame received from the socket is never copied. Waits
+    // while the target worker is full so per-instrument updates are never dropped.
+    void submit(ChannelId channel, std::string&& buffer, size_t offset, size_t length);
+
+    size_t worker_count() const { return workers_.size(); }
+    size_t backlog() const;
+
+private:
+    struct WorkItem {
+        ChannelId channel = kInvalidId;
+        size_t offset = 0;
+        size_t length = 0;
+        std::string buffer;
+    };
+
+    struct Worker {
+        explicit Worker(size_t queue_capacity) : queue(queue_capacity), wake_seq(0) {}
+        SpscQueue<WorkItem> queue;
+        std::atomic<uint32_t> wake_seq;
+        std::thread thread;
+    };
+
+    size_t worker_for(ChannelId channel) const;
+    void run(Worker& worker);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    MessageCallback message_callback_;
+    std::atomic<bool> running_;
+};
+
+#endif // MARKETDATAWORKERPOOL_HPP
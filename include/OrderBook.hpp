@@ -0,0 +1,52 @@
+// OrderBook.hpp
+
+#ifndef ORDERBOOK_HPP
+#define ORDERBOOK_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+struct PriceLevel {
+    double price;
+    double amount;
+};
+
+// Flat L2 book for a single instrument.
+// Each side is a contiguous array sorted so that the best level sits at the back
+// (bids ascending, asks descending): top of book is O(1) and most updates, which
+// land near the touch, only shift a few elements.
+class OrderBook {
+public:
+    enum class Side { Bid, Ask };
+
+    void clear();
+
+    // Apply a Deribit level update; action is "new", "change" or "delete"
+    void apply(Side side, std::string_view action, double price, double amount);
+    void set_level(Side side, double price, double amount);
+    void remove_level(Side side, double price);
+
+    bool best_bid(PriceLevel& level) const;
+    bool best_ask(PriceLevel& level) const;
+
+    // Copy up to depth levels, best first
+    void top_bids(size_t depth, std::vector<PriceLevel>& out) const;
+    void top_asks(size_t depth, std::vector<PriceLevel>& out) const;
+
+    size_t bid_depth() const { return bids_.size(); }
+    size_t ask_depth() const { return asks_.size(); }
+
+    uint64_t change_id() const { return change_id_; }
+    void set_change_id(uint64_t change_id) { change_id_ = change_id; }
+
+private:
+    std::vector<PriceLevel>& levels(Side side) { return side == Side::Bid ? bids_ : asks_; }
+    static void top(const std::vector<PriceLevel>& levels, size_t depth, std::vector<PriceLevel>& out);
+
+    std::vector<PriceLevel> bids_;
+    std::vector<PriceLevel> asks_;
+    uint64_t change_id_ = 0;
+};
+
+#endif // ORDERBOOK_HPP
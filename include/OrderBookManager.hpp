@@ -0,0 +1,62 @@
+// OrderBookManager.hpp
+
+#ifndef ORDERBOOKMANAGER_HPP
+#define ORDERBOOKMANAGER_HPP
+
+#include "BookDecoder.hpp"
+#include "DeribitAPI.hpp"
+#include "InstrumentRegistry.hpp"
+#include "OrderBook.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Maintains local L2 books from incremental book.<instrument>.<interval> channels.
+// After a gap the book is rebuilt from a public/get_order_book snapshot fetched
+// off the market data thread; updates received meanwhile are buffered and the
+// ones newer than the snapshot are replayed onto it.
+class OrderBookManager {
+public:
+    OrderBookManager(DeribitAPI& api);
+
+    // Feed a market data notification; returns false if the channel is not an
+    // incremental book channel (book.<instrument>.raw / book.<instrument>.100ms)
+    bool on_book_update(ChannelId channel, std::string_view data);
+
+    bool get_best_bid_ask(const std::string& instrument, PriceLevel& bid, PriceLevel& ask, bool& has_bid, bool& has_ask);
+    bool get_depth(const std::string& instrument, size_t depth, std::vector<PriceLevel>& bids, std::vector<PriceLevel>& asks);
+
+private:
+    struct InstrumentBook {
+        OrderBook book;
+        bool synced = false;   // Book reflects a snapshot plus a continuous update chain
+        bool bridging = false; // Rebuilt from REST; waiting for the first update to chain onto it
+        bool resyncing = false; // A REST snapshot request is in flight
+        uint64_t resync_generation = 0; // Identifies the current request; a WS snapshot supersedes it
+        int resync_failures = 0;
+        std::chrono::steady_clock::time_point next_resync; // Backoff after a failed request
+        std::vector<BookUpdate> buffered; // Updates received while not synced, oldest first
+        std::mutex mtx;
+    };
+
+    InstrumentBook* find_book(const std::string& instrument);
+    InstrumentBook& get_or_create_book(InstrumentId instrument);
+    bool apply_update(const std::string& instrument, InstrumentBook& entry, const BookUpdate& update);
+    static bool begin_resync(InstrumentBook& entry, uint64_t& generation);
+    static int64_t back_off(InstrumentBook& entry);
+    void request_snapshot(InstrumentId instrument, uint64_t generation);
+    void on_snapshot(InstrumentId instrument, uint64_t generation, const nlohmann::json& response);
+    static void apply_levels(OrderBook& book, OrderBook::Side side, const LevelBuffer& levels);
+
+    DeribitAPI& api_;
+    // Indexed by InstrumentId; slots are published once and never replaced
+    std::unique_ptr<std::atomic<InstrumentBook*>[]> books_;
+    std::vector<std::unique_ptr<InstrumentBook>> owned_books_;
+    std::mutex books_mtx_;
+};
+
+#endif // ORDERBOOKMANAGER_HPP
@@ -0,0 +1,34 @@
+// OrderEncoder.hpp
+
+#ifndef ORDERENCODER_HPP
+#define ORDERENCODER_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Writes order JSON-RPC requests straight into a reusable thread-local buffer.
+// The bytes are identical to dumping the equivalent nlohmann::json request
+// (keys in sorted order, the same number layout and string escaping), so the
+// exchange sees exactly what the generic path used to send. The returned view
+// stays valid until the next encode call on the same thread.
+class OrderEncoder {
+public:
+    // tick_size <= 0 means unknown; the price is then formatted generically
+    static std::string_view encode_buy(uint64_t id, std::string_view instrument, std::string_view direction,
+                                       double amount, double price, double tick_size);
+    static std::string_view encode_edit(uint64_t id, std::string_view order_id, double amount, double price);
+    static std::string_view encode_cancel(uint64_t id, std::string_view order_id);
+
+    // Shortest round-trip form as nlohmann prints it ("65000.5", "10.0", "1e-05")
+    static void append_double(std::string& out, double value, double tick_size = 0.0);
+
+private:
+    static std::string& begin_request(uint64_t id, std::string_view method);
+    static void append_uint(std::string& out, uint64_t value);
+    static void append_shortest(std::string& out, double value);
+    static void append_string(std::string& out, std::string_view value);
+    static bool append_on_tick(std::string& out, double value, double tick_size);
+};
+
+#endif // ORDERENCODER_HPP
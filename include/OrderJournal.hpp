@@ -0,0 +1,87 @@
+// OrderJournal.hpp
+
+#ifndef ORDERJOURNAL_HPP
+#define ORDERJOURNAL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Append-only journal of order intents and exchange acknowledgements in a
+// memory-mapped file of fixed-size records. Appending is a copy into the
+// mapping, with no system call; the kernel writes the pages back, so records
+// survive a crash of the process (not of the machine). A record is committed
+// by writing its sequence number last, so a record torn by a crash ends the
+// replay instead of being misread. When the file fills up, the owner rewrites
+// it with just the live state. Not thread-safe: callers serialize access.
+class OrderJournal {
+public:
+    enum class RecordType : uint8_t {
+        Intent = 1, // Order about to be sent; no order id yet
+        Open = 2,   // Full state of an acknowledged open order
+        Closed = 3  // Filled, cancelled or rejected
+    };
+
+    struct Record {
+        uint64_t sequence;   // Position + 1, written last; 0 ends the journal
+        uint64_t intent_id;  // Links an Intent to the Open record of its order; 0 if none
+        int64_t timestamp_ns;
+        double quantity;
+        double price;
+        double filled_quantity;
+        RecordType type;
+        uint8_t is_sell;
+        char order_id[32];   // NUL-terminated, truncated if longer
+        char instrument[46];
+    };
+    static_assert(sizeof(Record) == 128, "journal records are a fixed 128 bytes");
+
+    // capacity is in records; the file is created or extended to fit it, and a
+    // larger existing file keeps its size
+    OrderJournal(const std::string& path, size_t capacity);
+    ~OrderJournal();
+
+    bool is_open() const { return records_ != nullptr; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+
+    // Committed records in append order
+    void replay(const std::function<void(const Record&)>& apply) const;
+
+    // Fills in sequence and timestamp; false when the journal is full or closed
+    bool append(Record record);
+
+    // Atomically replaces the contents (temp file and rename). The capacity grows
+    // to twice the record count when they would fill more than half of it, so a
+    // large live state is not compacted again on every append.
+    bool rewrite(const std::vector<Record>& records);
+
+    static Record make_record(RecordType type, const std::string& order_id, const std::string& instrument,
+                              const std::string& side, double quantity, double price, double filled_quantity = 0.0);
+
+private:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint64_t capacity;
+        char padding[104];
+    };
+    static_assert(sizeof(Header) == sizeof(Record), "the header occupies the first record slot");
+
+    bool map_file(const std::string& path);
+    void write_record(Record record);
+    void unmap();
+
+    std::string path_;
+    size_t capacity_;
+    int fd_;
+    void* mapping_;
+    size_t mapping_size_;
+    Record* records_; // Follows the header in the mapping
+    size_t size_;
+};
+
+#endif // ORDERJOURNAL_HPP
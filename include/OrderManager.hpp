@@ -2,30 +2,88 @@
 #define ORDERMANAGER_HPP
 
 #include "DeribitAPI.hpp"
+#include "OrderTable.hpp"
+#include "PositionCache.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <mutex>
+#include <vector>
 
-struct Order {
-    std::string order_id;
+struct OrderRequest {
     std::string instrument;
     std::string side;
     double quantity;
     double price;
 };
 
+struct OrderModification {
+    std::string order_id;
+    double new_quantity;
+    double new_price;
+};
+
 class OrderManager {
 public:
-    OrderManager(DeribitAPI& api);
+    // Subscribes to user.orders and user.trades so fills, partial fills and
+    // exchange-side cancels are applied as they happen. With a journal path the
+    // table is first restored from the journal; either way it is reconciled with
+    // private/get_open_orders before the constructor returns.
+    OrderManager(DeribitAPI& api, const PositionCache& positions, const std::string& journal_path = "",
+                 size_t journal_capacity = 65536);
     
     std::string place_order(const std::string& instrument, const std::string& side, double quantity, double price);
     bool cancel_order(const std::string& order_id);
     bool modify_order(const std::string& order_id, double new_quantity, double new_price);
-    std::unordered_map<std::string, Order> get_current_orders();
+
+    // Lock-free: returns the latest published snapshot, shared rather than copied
+    std::shared_ptr<const OrderSnapshot> get_current_orders() const;
+
+    // Streamed position; no REST round trip
+    bool get_position(const std::string& instrument, Position& position) const;
+
+    // Exchange-side mass cancel; returns the number of orders cancelled, or -1 on error
+    int cancel_all();
+    int cancel_all_by_instrument(const std::string& instrument);
+
+    // Send every request at once and wait for all responses, so a batch costs about one
+    // round trip; the order table is updated under a single lock. Results are in input order
+    // (empty id / false for failures).
+    std::vector<std::string> place_orders(const std::vector<OrderRequest>& requests);
+    std::vector<bool> modify_orders(const std::vector<OrderModification>& modifications);
+
+    // Fire-and-continue variants: return immediately so many orders can be in flight
+    // at once. done runs on the transport thread with the order id ("" on failure)
+    // or the success flag, and must not block.
+    void place_order_async(const std::string& instrument, const std::string& side, double quantity, double price,
+                           std::function<void(const std::string&)> done = nullptr);
+    void cancel_order_async(const std::string& order_id, std::function<void(bool)> done = nullptr);
+    void modify_order_async(const std::string& order_id, double new_quantity, double new_price,
+                            std::function<void(bool)> done = nullptr);
     
 private:
+    std::string handle_place_response(uint64_t intent_id, const std::string& instrument, const std::string& side,
+                                      double quantity, double price, const nlohmann::json& response);
+    bool handle_cancel_response(const std::string& order_id, const nlohmann::json& response);
+    bool handle_modify_response(double new_quantity, double new_price, const nlohmann::json& response);
+    static std::string extract_order_id(const std::string& operation, const nlohmann::json& response);
+    int handle_mass_cancel_response(const std::string& instrument, const nlohmann::json& response);
+
+    // Exchange notifications, on the dispatcher thread
+    void on_user_message(ChannelId channel, std::string_view data);
+
+    void reconcile();
+    uint64_t record_intent(const std::string& instrument, const std::string& side, double quantity, double price);
+
     DeribitAPI& api_;
-    std::unordered_map<std::string, Order> orders_;
+    const PositionCache& positions_;
+    ChannelId orders_channel_;
+    ChannelId trades_channel_;
+
+    // Intents are journaled before the request is sent, everything else as the table changes
+    OrderTable table_; // Guarded by mtx_, except for snapshots
     std::mutex mtx_;
 };
 
@@ -0,0 +1,107 @@
+// OrderTable.hpp
+
+#ifndef ORDERTABLE_HPP
+#define ORDERTABLE_HPP
+
+#include "OrderJournal.hpp"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+struct Order {
+    std::string order_id;
+    std::string instrument;
+    std::string side;
+    double quantity;
+    double price;
+    double filled_quantity = 0.0; // From user.orders / user.trades
+};
+
+// Open orders at one point in time; immutable once published
+typedef std::vector<Order> OrderSnapshot;
+
+// The open orders of OrderManager, without the exchange: a dense slot table,
+// the journal that lets it survive a restart and the snapshot readers see.
+// Changes become visible to readers, and are journaled, on publish(). Not
+// thread-safe except for snapshot(): the owner serializes everything else.
+class OrderTable {
+public:
+    // With a journal path the table is restored from the journal before the
+    // journal is attached, so nothing replayed is journaled again
+    explicit OrderTable(const std::string& journal_path = "", size_t journal_capacity = 65536);
+
+    bool journaling() const { return journal_ != nullptr; }
+
+    // Journals the order before it is sent; 0 when journaling is off. Every
+    // intent must be settled once its response arrives.
+    uint64_t record_intent(const std::string& instrument, const std::string& side, double quantity, double price);
+    // The response to an intent: an empty order id means the place failed.
+    // Returns false if the order is not in the table (failed or already closed).
+    bool settle_intent(uint64_t intent_id, const std::string& order_id, const std::string& instrument,
+                       const std::string& side, double quantity, double price);
+    size_t unacknowledged_intents() const { return intents_.size(); }
+
+    // Late responses for an order the exchange already closed are ignored
+    bool modify(const std::string& order_id, double quantity, double price);
+    bool remove(const std::string& order_id);
+    // Open order ids, for one instrument or every instrument if empty
+    std::vector<std::string> order_ids(const std::string& instrument = "") const;
+    bool contains(const std::string& order_id) const { return slot_by_order_id_.count(order_id) != 0; }
+    size_t size() const { return slot_by_order_id_.size(); }
+
+    // Exchange notifications: full order state from user.orders, executions from user.trades
+    void apply_order_update(const nlohmann::json& order);
+    void apply_trade(const nlohmann::json& trade);
+
+    // Journal the changed orders and publish a new snapshot
+    void publish();
+    // Lock-free: the latest published snapshot, shared rather than copied
+    std::shared_ptr<const OrderSnapshot> snapshot() const { return snapshot_.load(std::memory_order_acquire); }
+
+    // Replace the journal with the live state: the open orders and every
+    // intent that has not been settled yet
+    void checkpoint();
+
+private:
+    typedef uint32_t OrderSlot;
+    struct SlotEntry {
+        Order order;
+        double trade_filled = 0.0; // Sum of user.trades amounts, a lower bound on the fill
+        uint64_t intent_id = 0;
+        bool active = false;
+        bool dirty = false; // Changed since it was last journaled
+    };
+
+    SlotEntry* find(const std::string& order_id);
+    SlotEntry* upsert(const std::string& order_id, const std::string& instrument, const std::string& side,
+                      double quantity, double price);
+    void replay(OrderJournal& journal);
+    void journal(const OrderJournal::Record& record);
+
+    static const size_t kMaxRecentlyClosed = 4096;
+
+    // Dense table indexed by slot; the string id is only resolved at the edges.
+    // Vacated slots are reused, so the table stays as large as the peak open count.
+    std::vector<SlotEntry> slots_;
+    std::vector<OrderSlot> free_slots_;
+    std::unordered_map<std::string, OrderSlot> slot_by_order_id_;
+    // Orders the exchange reported closed, so a late place/modify response cannot revive them
+    std::unordered_set<std::string> recently_closed_;
+    std::deque<std::string> recently_closed_order_;
+
+    std::unique_ptr<OrderJournal> journal_; // Null when journaling is off
+    uint64_t next_intent_id_;
+    // Intent records sent but not yet settled, by intent id, kept for compaction
+    std::map<uint64_t, OrderJournal::Record> intents_;
+
+    std::atomic<std::shared_ptr<const OrderSnapshot>> snapshot_;
+};
+
+#endif // ORDERTABLE_HPP
@@ -0,0 +1,93 @@
+// PositionCache.hpp
+
+#ifndef POSITIONCACHE_HPP
+#define POSITIONCACHE_HPP
+
+#include "DeribitAPI.hpp"
+#include "InstrumentRegistry.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct Position {
+    std::string instrument;
+    double size = 0.0; // Negative when short
+    double average_price = 0.0;
+    double mark_price = 0.0;
+    double floating_pnl = 0.0;
+    double realized_pnl = 0.0;
+    double delta = 0.0;
+};
+
+struct Portfolio {
+    std::string currency;
+    double equity = 0.0;
+    double balance = 0.0;
+    double margin_balance = 0.0;
+    double available_funds = 0.0;
+    double initial_margin = 0.0;
+    double maintenance_margin = 0.0;
+    double total_pl = 0.0;
+};
+
+// Positions and account summaries kept current from the user.changes and
+// user.portfolio subscriptions. REST is used once for the initial positions
+// and then periodically to correct any drift; lookups never leave the process.
+class PositionCache {
+public:
+    // reconcile_interval_s = 0 disables the periodic check
+    PositionCache(DeribitAPI& api, int reconcile_interval_s = 60);
+    ~PositionCache();
+
+    // Constant time; false if no position was ever reported for the instrument
+    bool get_position(const std::string& instrument, Position& position) const;
+    // Every instrument with a non-zero size
+    std::vector<Position> get_positions() const;
+    bool get_portfolio(const std::string& currency, Portfolio& portfolio) const;
+
+    // Compare with private/get_positions and take the exchange's values where they differ
+    void reconcile();
+
+private:
+    struct Entry {
+        Position position;
+        uint64_t stream_seq = 0; // Last streamed update applied to this entry
+        std::mutex mtx;
+    };
+
+    void on_user_message(ChannelId channel, std::string_view data);
+    void apply_position(const nlohmann::json& position, uint64_t stream_seq);
+    void apply_portfolio(const nlohmann::json& portfolio);
+    Entry* find_entry(const std::string& instrument) const;
+    Entry& get_or_create_entry(InstrumentId instrument);
+    void run_reconcile();
+
+    DeribitAPI& api_;
+    ChannelId changes_channel_;
+    ChannelId portfolio_channel_;
+
+    // Indexed by InstrumentId; slots are published once and never replaced
+    std::unique_ptr<std::atomic<Entry*>[]> entries_;
+    std::vector<std::unique_ptr<Entry>> owned_entries_;
+    mutable std::mutex entries_mtx_;
+
+    std::atomic<uint64_t> stream_seq_; // Streamed position updates applied so far
+
+    std::unordered_map<std::string, Portfolio> portfolios_;
+    mutable std::mutex portfolio_mtx_;
+
+    int reconcile_interval_s_;
+    bool running_; // Guarded by reconcile_mtx_
+    std::mutex reconcile_mtx_;
+    std::condition_variable reconcile_cv_;
+    std::thread reconcile_thread_;
+};
+
+#endif // POSITIONCACHE_HPP
@@ -0,0 +1,91 @@
+// RateLimiter.hpp
+
+#ifndef RATELIMITER_HPP
+#define RATELIMITER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Client-side model of Deribit's rate limits, so bursts are smoothed locally
+// instead of earning too_many_requests and the exchange's back-off. Two token
+// buckets: one for matching engine requests (buy, sell, edit, cancel...) and
+// one for everything else, each refilled continuously up to its burst size.
+// A request that finds no credit is queued and released by the governor
+// thread as credit returns, cancels ahead of everything else. New orders may
+// not spend the last cancel_reserve matching engine credits, and one that
+// would wait longer than max_queue_ms is shed rather than sent late.
+class RateLimiter {
+public:
+    enum class Pool { MatchingEngine, NonMatching };
+    enum class Priority { Cancel, Normal };
+
+    struct Limits {
+        double rate;  // Requests per second
+        double burst; // Bucket size in requests
+    };
+
+    // admitted is false if the request was shed or the limiter stopped first
+    typedef std::function<void(bool admitted)> Task;
+
+    struct Stats {
+        uint64_t immediate; // Sent without waiting
+        uint64_t queued;
+        uint64_t shed;
+        uint64_t throttled; // too_many_requests answers from the exchange
+    };
+
+    RateLimiter(Limits matching_engine, Limits non_matching, double cancel_reserve, int max_queue_ms);
+    ~RateLimiter();
+
+    // Takes a credit if one is available right now and nothing is queued ahead
+    bool try_acquire(Pool pool, Priority priority);
+
+    // Runs task(true) on this thread if a credit is available, otherwise later on
+    // the governor thread; task(false) runs here if the request is shed.
+    // Cancels are never shed.
+    void submit(Pool pool, Priority priority, Task task);
+
+    // The exchange rejected a request as too_many_requests: empty the pool so
+    // queued requests wait for it to refill
+    void on_throttled(Pool pool);
+
+    Stats get_stats() const;
+
+private:
+    struct Bucket {
+        Limits limits;
+        double reserve; // Credits only cancels may take
+        double credits;
+        std::chrono::steady_clock::time_point updated;
+        std::deque<Task> cancels;
+        std::deque<Task> normal;
+    };
+
+    Bucket& bucket(Pool pool) { return pool == Pool::MatchingEngine ? matching_engine_ : non_matching_; }
+    void refill_locked(Bucket& bucket, std::chrono::steady_clock::time_point now);
+    bool take_locked(Bucket& bucket, Priority priority);
+    std::chrono::steady_clock::duration next_release_locked(const Bucket& bucket) const;
+    void run();
+
+    Bucket matching_engine_;
+    Bucket non_matching_;
+    std::chrono::milliseconds max_queue_;
+
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    bool running_; // Guarded by mtx_
+    std::thread thread_;
+
+    std::atomic<uint64_t> immediate_;
+    std::atomic<uint64_t> queued_;
+    std::atomic<uint64_t> shed_;
+    std::atomic<uint64_t> throttled_;
+};
+
+#endif // RATELIMITER_HPP
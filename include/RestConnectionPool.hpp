@@ -0,0 +1,63 @@
+// RestConnectionPool.hpp
+
+#ifndef RESTCONNECTIONPOOL_HPP
+#define RESTCONNECTIONPOOL_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <curl/curl.h>
+
+// Small pool of long-lived curl handles for JSON-RPC POSTs to one endpoint.
+// Each handle keeps its own keep-alive connection; DNS results and TLS sessions
+// are shared across the pool. Handles are connected up front and a background
+// thread pings any handle left idle, so a request after a quiet period does not
+// pay for a new TCP/TLS handshake.
+class RestConnectionPool {
+public:
+    RestConnectionPool(const std::string& url, size_t pool_size, int keepalive_ping_ms);
+    ~RestConnectionPool();
+
+    // Connect every handle concurrently and start the idle ping thread
+    void warm_up();
+
+    // POST body; auth_token may be empty. Blocks for a free handle if all are busy.
+    // Returns false on transport errors (response is left empty).
+    bool post(const std::string& body, const std::string& auth_token, std::string& response);
+
+private:
+    struct Handle {
+        CURL* curl = nullptr;
+        curl_slist* headers = nullptr;      // Content-Type only
+        curl_slist* auth_headers = nullptr; // Content-Type + Authorization for auth_token
+        std::string auth_token;
+        std::chrono::steady_clock::time_point last_used;
+    };
+
+    size_t acquire();
+    void release(size_t index);
+    bool perform(Handle& handle, const std::string& body, const std::string& auth_token, std::string& response);
+    void ping_idle_handles();
+
+    static void lock_share(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr);
+    static void unlock_share(CURL* handle, curl_lock_data data, void* userptr);
+
+    std::string url_;
+    std::chrono::milliseconds keepalive_ping_;
+    CURLSH* share_;
+    std::mutex share_mtx_[CURL_LOCK_DATA_LAST];
+    std::vector<Handle> handles_;
+
+    std::vector<size_t> free_handles_;
+    std::mutex pool_mtx_;
+    std::condition_variable pool_cv_;
+
+    bool running_; // Guarded by pool_mtx_
+    std::condition_variable ping_cv_;
+    std::thread ping_thread_;
+};
+
+#endif // RESTCONNECTIONPOOL_HPP
@@ -0,0 +1,63 @@
+// RpcAwaitable.hpp
+
+#ifndef RPCAWAITABLE_HPP
+#define RPCAWAITABLE_HPP
+
+#include <coroutine>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+
+// co_await-able result of a JSON-RPC request. Completes with the full response
+// (result or error). The awaiting coroutine is resumed on the thread that delivers
+// the response, i.e. the market data dispatcher thread for WebSocket requests, so
+// the continuation should not block.
+class RpcAwaitable {
+public:
+    struct State {
+        std::mutex mtx;
+        bool ready = false;
+        nlohmann::json response;
+        std::coroutine_handle<> waiter;
+
+        void complete(const nlohmann::json& result) {
+            std::coroutine_handle<> handle;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                response = result;
+                ready = true;
+                handle = waiter;
+            }
+            if (handle) {
+                handle.resume();
+            }
+        }
+    };
+
+    explicit RpcAwaitable(std::shared_ptr<State> state) : state_(std::move(state)) {}
+
+    bool await_ready() const {
+        std::lock_guard<std::mutex> lock(state_->mtx);
+        return state_->ready;
+    }
+
+    // Returns false (resume immediately) if the response arrived in the meantime
+    bool await_suspend(std::coroutine_handle<> handle) {
+        std::lock_guard<std::mutex> lock(state_->mtx);
+        if (state_->ready) {
+            return false;
+        }
+        state_->waiter = handle;
+        return true;
+    }
+
+    nlohmann::json await_resume() {
+        std::lock_guard<std::mutex> lock(state_->mtx);
+        return std::move(state_->response);
+    }
+
+private:
+    std::shared_ptr<State> state_;
+};
+
+#endif // RPCAWAITABLE_HPP
@@ -0,0 +1,39 @@
+// SubscriptionParser.hpp
+
+#ifndef SUBSCRIPTIONPARSER_HPP
+#define SUBSCRIPTIONPARSER_HPP
+
+#include <string_view>
+
+// Views into a raw "subscription" notification frame
+struct SubscriptionView {
+    std::string_view channel;
+    std::string_view data; // Raw JSON text of params.data
+};
+
+// Streaming scanner for Deribit "method":"subscription" frames.
+// Walks the payload once without building a DOM and returns spans into the
+// original buffer, so the views are only valid while the payload is alive.
+class SubscriptionParser {
+public:
+    // Returns false if the frame is not a subscription notification or uses a
+    // form the fast path does not handle (e.g. escaped channel name); callers
+    // should fall back to a full parse in that case.
+    static bool parse(std::string_view payload, SubscriptionView& view);
+
+    // True if the frame is a JSON-RPC response (it has an id, result or error
+    // before any method). Deribit puts these keys first, so this reads a few bytes.
+    static bool is_response(std::string_view payload);
+
+    // Scanning primitives, shared with BookDecoder
+    static void skip_whitespace(std::string_view payload, size_t& pos);
+    static bool read_plain_string(std::string_view payload, size_t& pos, std::string_view& out);
+    static bool skip_value(std::string_view payload, size_t& pos);
+
+private:
+    static bool skip_string(std::string_view payload, size_t& pos);
+    static bool parse_params(std::string_view payload, size_t& pos, SubscriptionView& view,
+                             bool& has_channel, bool& has_data);
+};
+
+#endif // SUBSCRIPTIONPARSER_HPP
@@ -4,50 +4,101 @@
 #define WEBSOCKETSERVER_HPP
 
 #include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/extensions/permessage_deflate/enabled.hpp>
 #include <websocketpp/server.hpp>
-#include <set>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <string>
 #include <mutex>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <string_view>
+#include <vector>
 #include <nlohmann/json.hpp> // Include JSON library
+#include "HeldQueue.hpp"
+#include "InstrumentRegistry.hpp"
 
-typedef websocketpp::server<websocketpp::config::asio> Server;
+// The plain asio server config with permessage-deflate offered to clients
+struct ServerConfig : public websocketpp::config::asio {
+    typedef ServerConfig type;
+    typedef websocketpp::config::asio base;
 
-// Custom equality comparator for websocketpp::connection_hdl
-struct connection_hdl_equal {
-    bool operator()(const websocketpp::connection_hdl& a, const websocketpp::connection_hdl& b) const {
-        auto sa = a.lock();
-        auto sb = b.lock();
-        return sa.get() == sb.get();
-    }
-};
+    typedef base::concurrency_type concurrency_type;
+    typedef base::request_type request_type;
+    typedef base::response_type response_type;
+    typedef base::message_type message_type;
+    typedef base::con_msg_manager_type con_msg_manager_type;
+    typedef base::endpoint_msg_manager_type endpoint_msg_manager_type;
+    typedef base::alog_type alog_type;
+    typedef base::elog_type elog_type;
+    typedef base::rng_type rng_type;
 
-// Add the hash specialization within the std namespace
-namespace std {
-    template <>
-    struct hash<websocketpp::connection_hdl> {
-        std::size_t operator()(const websocketpp::connection_hdl& hdl) const {
-            // Lock the weak_ptr to obtain a shared_ptr
-            auto sp = hdl.lock();
-            // Hash the raw pointer held by the shared_ptr
-            return std::hash<void*>()(sp.get());
-        }
+    struct transport_config : public base::transport_config {
+        typedef type::concurrency_type concurrency_type;
+        typedef type::alog_type alog_type;
+        typedef type::elog_type elog_type;
+        typedef type::request_type request_type;
+        typedef type::response_type response_type;
+        typedef websocketpp::transport::asio::basic_socket::endpoint socket_type;
     };
-}
+    typedef websocketpp::transport::asio::endpoint<transport_config> transport_type;
+
+    struct permessage_deflate_config {};
+    typedef websocketpp::extensions::permessage_deflate::enabled<permessage_deflate_config> permessage_deflate_type;
+};
+
+typedef websocketpp::server<ServerConfig> Server;
+
+// Assigned when a client connects and never reused
+typedef uint64_t ClientId;
+
+struct WebSocketServerOptions {
+    // Threads running the server's io_context; websocketpp gives every
+    // connection its own strand, so one client's handlers never run concurrently
+    size_t io_threads = 1;
+
+    // A client with more than this many bytes not yet written to its socket is
+    // slow: broadcasts to it are held back instead of growing its send buffer
+    size_t send_high_water_bytes = 1 << 20;
+    size_t send_queue_limit = 1024; // Held-back messages per client
+    SlowConsumerPolicy slow_consumer_policy = SlowConsumerPolicy::DropOldest;
+
+    // Compress JSON messages for clients that negotiated permessage-deflate;
+    // costs a compression per client per message instead of one shared frame
+    bool permessage_deflate = true;
+};
+
+struct ClientStats {
+    ClientId id;
+    size_t queue_depth;    // Messages held back
+    size_t buffered_bytes; // Handed to websocketpp, not yet written to the socket
+    uint64_t sent;
+    uint64_t dropped;
+    uint64_t conflated;    // Replaced by a newer message for the same symbol
+    bool binary;           // Subscribed with "encoding": "binary"
+    bool deflate;          // JSON messages are compressed
+};
 
 class WebSocketServer {
 public:
-    WebSocketServer(int port);
+    WebSocketServer(int port, const WebSocketServerOptions& options = WebSocketServerOptions());
+    ~WebSocketServer();
+    // Blocks until stop(); the calling thread is one of the io threads
     void run();
     void stop();
     
     void subscribe(const std::string& symbol);
     void unsubscribe(const std::string& symbol);
     
-    // Broadcast market data to subscribed clients
-    void broadcast(const std::string& symbol, const std::string& message);
+    // Broadcast a market data notification to clients subscribed to the channel's
+    // instrument. Each encoding is framed once and the same buffer is queued on
+    // every connection that uses it; only deflate clients get a copy of their own.
+    void broadcast(ChannelId channel, std::string_view message);
+
+    std::vector<ClientStats> get_client_stats();
     
 private:
     void on_open(websocketpp::connection_hdl hdl);
@@ -56,25 +107,83 @@ private:
     
     void handle_subscribe(websocketpp::connection_hdl hdl, const nlohmann::json& payload);
     void handle_unsubscribe(websocketpp::connection_hdl hdl, const nlohmann::json& payload);
+
+    static Server::message_ptr make_frame(std::string_view payload, websocketpp::frame::opcode::value opcode);
+    static Server::message_ptr make_compressible(std::string_view payload);
     
+    // Outbound state shared by every subscriber list the client is in
+    struct ClientState {
+        ClientState(size_t queue_limit, SlowConsumerPolicy policy) : held(queue_limit, policy) {}
+
+        ClientId id;
+        Server::connection_ptr connection;
+        bool deflate = false; // Negotiated and enabled; fixed at open
+
+        // Everything below is guarded by mtx
+        std::mutex mtx;
+        bool binary = false;
+        HeldQueue<Server::message_ptr> held; // Waiting for the send buffer to drain
+        bool backlogged = false; // Listed in backlogged_
+        bool closing = false;
+        uint64_t sent = 0;
+        uint64_t dropped = 0;
+        uint64_t conflated = 0;
+    };
+
+    struct Client {
+        std::shared_ptr<ClientState> state;
+        std::vector<bool> subscribed; // Indexed by InstrumentId
+        std::unordered_set<std::string> pending; // Subscribed before the registry knew them
+    };
+
+    typedef std::vector<std::shared_ptr<ClientState>> SubscriberList;
+
+    // The encodings of one broadcast, each built on first use
+    struct Frames {
+        ChannelId channel;
+        ChannelType type;
+        InstrumentId symbol;
+        std::string_view message;
+        Server::message_ptr text;    // Prepared, shared as is
+        Server::message_ptr deflate; // Compressed by each connection
+        Server::message_ptr binary;  // Prepared, shared as is
+        bool binary_tried = false;
+    };
+    static const Server::message_ptr& frame_for(Frames& frames, const ClientState& client);
+
+    ClientId find_client_locked(websocketpp::connection_hdl hdl) const;
+    // Copy-on-write update of one symbol's list; returns its new size
+    size_t add_subscriber_locked(InstrumentId symbol, const std::shared_ptr<ClientState>& client);
+    size_t remove_subscriber_locked(InstrumentId symbol, ClientId id);
+    void attach_locked(Client& client, InstrumentId id);
+    void on_instrument_added(InstrumentId id);
+
+    // Queue a frame for a slow client, applying the slow consumer policy
+    void hold_locked(const std::shared_ptr<ClientState>& client, const Frames& frames, const Server::message_ptr& frame);
+    // Send held frames while the client's send buffer is below the high-water mark
+    void drain_locked(ClientState& client);
+    void schedule_flush();
+    void flush_backlogged();
+
     Server server_;
-    std::set<websocketpp::connection_hdl, std::owner_less<websocketpp::connection_hdl>> connections_;
-    std::mutex connections_mtx_;
-    
-    // Mapping from connection handle to subscribed symbols
-    std::unordered_map<
-        websocketpp::connection_hdl, 
-        std::unordered_set<std::string>, 
-        std::hash<websocketpp::connection_hdl>, 
-        connection_hdl_equal
-    > client_subscriptions_;
+
+    // Connection bookkeeping, all guarded by subscriptions_mtx_; handles are
+    // ordered by owner so lookups never lock the weak_ptr
+    std::map<websocketpp::connection_hdl, ClientId, std::owner_less<websocketpp::connection_hdl>> client_ids_;
+    std::unordered_map<ClientId, Client> clients_;
+    ClientId next_client_id_;
     std::mutex subscriptions_mtx_;
-    
-    // Mapping from symbol to number of subscriptions
-    std::unordered_map<std::string, int> symbol_subscription_count_;
-    std::mutex symbol_mtx_;
+
+    // Inverted index read by broadcast without locking, indexed by InstrumentId;
+    // writers publish a new list under subscriptions_mtx_
+    std::unique_ptr<std::atomic<std::shared_ptr<const SubscriberList>>[]> subscribers_;
+
+    // Clients with held frames, drained by a timer on the io threads
+    std::vector<std::shared_ptr<ClientState>> backlogged_;
+    std::mutex backlog_mtx_;
     
     int port_;
+    WebSocketServerOptions options_;
 };
 
 #endif // WEBSOCKETSERVER_HPP
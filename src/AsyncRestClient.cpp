@@ -0,0 +1,170 @@
+// AsyncRestClient.cpp
+
+#include "AsyncRestClient.hpp"
+#include "Logger.hpp"
+
+// Longest the client thread sleeps in curl_multi_poll; posts wake it immediately
+static const int kPollTimeoutMs = 1000;
+
+// Helper function to write response data
+static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp)
+{
+    ((std::string*)userp)->append((char*)contents, size * nmemb);
+    return size * nmemb;
+}
+
+AsyncRestClient::AsyncRestClient(const std::string& url, long max_connections, long timeout_ms)
+    : url_(url), timeout_ms_(timeout_ms), multi_(curl_multi_init()), in_flight_(0), running_(true) {
+    curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS, max_connections);
+    thread_ = std::thread(&AsyncRestClient::run, this);
+}
+
+AsyncRestClient::~AsyncRestClient() {
+    {
+        std::lock_guard<std::mutex> lock(submit_mtx_);
+        running_ = false;
+    }
+    curl_multi_wakeup(multi_);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    for (CURL* curl : idle_handles_) {
+        curl_easy_cleanup(curl);
+    }
+    curl_multi_cleanup(multi_);
+}
+
+void AsyncRestClient::post(std::string body, const std::string& auth_token, Callback callback) {
+    Request* request = new Request();
+    request->body = std::move(body);
+    request->callback = std::move(callback);
+    request->headers = curl_slist_append(nullptr, "Content-Type: application/json");
+    if (!auth_token.empty()) {
+        request->headers = curl_slist_append(request->headers, ("Authorization: Bearer " + auth_token).c_str());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(submit_mtx_);
+        if (!running_) {
+            curl_slist_free_all(request->headers);
+            delete request;
+            return;
+        }
+        submitted_.push_back(request);
+        ++in_flight_;
+    }
+    curl_multi_wakeup(multi_);
+}
+
+size_t AsyncRestClient::in_flight() const {
+    std::lock_guard<std::mutex> lock(submit_mtx_);
+    return in_flight_;
+}
+
+CURL* AsyncRestClient::acquire_handle() {
+    if (!idle_handles_.empty()) {
+        CURL* curl = idle_handles_.back();
+        idle_handles_.pop_back();
+        return curl;
+    }
+
+    CURL* curl = curl_easy_init();
+    curl_easy_setopt(curl, CURLOPT_URL, url_.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_NODELAY, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, 5000L);
+    // A request stalled after connecting must still complete
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeout_ms_);
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    // Queue behind a connection that is still negotiating instead of opening a new one
+    curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    return curl;
+}
+
+void AsyncRestClient::start_request(Request* request) {
+    active_.insert(request);
+    request->curl = acquire_handle();
+    curl_easy_setopt(request->curl, CURLOPT_POSTFIELDS, request->body.c_str());
+    curl_easy_setopt(request->curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(request->body.size()));
+    curl_easy_setopt(request->curl, CURLOPT_HTTPHEADER, request->headers);
+    curl_easy_setopt(request->curl, CURLOPT_WRITEDATA, &request->response);
+    curl_easy_setopt(request->curl, CURLOPT_PRIVATE, request);
+
+    CURLMcode rc = curl_multi_add_handle(multi_, request->curl);
+    if (rc != CURLM_OK) {
+        Logger::getInstance().log("CURL multi error: " + std::string(curl_multi_strerror(rc)));
+        finish_request(request, CURLE_FAILED_INIT);
+    }
+}
+
+void AsyncRestClient::finish_request(Request* request, CURLcode result) {
+    curl_multi_remove_handle(multi_, request->curl);
+    idle_handles_.push_back(request->curl);
+    active_.erase(request);
+
+    try {
+        request->callback(result, request->response);
+    } catch (const std::exception& e) {
+        Logger::getInstance().log("REST completion callback error: " + std::string(e.what()));
+    }
+
+    curl_slist_free_all(request->headers);
+    delete request;
+
+    std::lock_guard<std::mutex> lock(submit_mtx_);
+    --in_flight_;
+}
+
+void AsyncRestClient::run() {
+    std::vector<Request*> submitted;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(submit_mtx_);
+            if (!running_) {
+                break;
+            }
+            submitted.swap(submitted_);
+        }
+        for (Request* request : submitted) {
+            start_request(request);
+        }
+        submitted.clear();
+
+        int running_handles = 0;
+        curl_multi_perform(multi_, &running_handles);
+
+        CURLMsg* msg;
+        int queued = 0;
+        while ((msg = curl_multi_info_read(multi_, &queued))) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+            Request* request = nullptr;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &request);
+            CURLcode result = msg->data.result;
+            if (result != CURLE_OK) {
+                Logger::getInstance().log("CURL error: " + std::string(curl_easy_strerror(result)));
+            }
+            finish_request(request, result);
+        }
+
+        curl_multi_poll(multi_, nullptr, 0, kPollTimeoutMs, nullptr);
+    }
+
+    // Shutting down: fail whatever is still queued or in flight
+    {
+        std::lock_guard<std::mutex> lock(submit_mtx_);
+        submitted.swap(submitted_);
+    }
+    for (Request* request : submitted) {
+        active_.insert(request);
+        request->curl = acquire_handle();
+    }
+    while (!active_.empty()) {
+        finish_request(*active_.begin(), CURLE_ABORTED_BY_CALLBACK);
+    }
+}
@@ -0,0 +1,131 @@
+// BinaryEncoder.cpp
+
+#include "BinaryEncoder.hpp"
+#include "BookDecoder.hpp"
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <nlohmann/json.hpp>
+
+// Records are copied out in host byte order, which the wire format fixes as little-endian
+static_assert(std::endian::native == std::endian::little, "binary market data assumes a little-endian host");
+static_assert(sizeof(BinaryEncoder::Header) == 16, "wire layout");
+static_assert(sizeof(BinaryEncoder::BookHeader) == 16, "wire layout");
+static_assert(sizeof(BinaryEncoder::BookLevel) == 24, "wire layout");
+static_assert(sizeof(BinaryEncoder::TradeRecord) == 40, "wire layout");
+static_assert(sizeof(BinaryEncoder::TickerRecord) == 64, "wire layout");
+
+template <typename T>
+static void append_record(std::string& out, const T& record) {
+    out.append(reinterpret_cast<const char*>(&record), sizeof(T));
+}
+
+static void append_header(std::string& out, BinaryEncoder::MessageType type, uint8_t flags, InstrumentId instrument,
+                          size_t count) {
+    BinaryEncoder::Header header{};
+    header.type = type;
+    header.flags = flags;
+    header.instrument = instrument;
+    header.count = static_cast<uint32_t>(count);
+    append_record(out, header);
+}
+
+// Ticker fields are null (last_price before the first trade) or absent (quote channels)
+static double number_or_nan(const nlohmann::json& data, const char* key) {
+    auto it = data.find(key);
+    if (it == data.end() || !it->is_number()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return it->get<double>();
+}
+
+std::string_view BinaryEncoder::encode(ChannelType type, InstrumentId instrument, std::string_view data) {
+    thread_local std::string buffer;
+    buffer.clear();
+
+    bool encoded = false;
+    switch (type) {
+    case ChannelType::Book:
+        encoded = encode_book(instrument, data, buffer);
+        break;
+    case ChannelType::Trades:
+        encoded = encode_trades(instrument, data, buffer);
+        break;
+    case ChannelType::Ticker:
+    case ChannelType::Quote:
+        encoded = encode_ticker(instrument, data, buffer);
+        break;
+    default:
+        break;
+    }
+    return encoded ? std::string_view(buffer) : std::string_view();
+}
+
+bool BinaryEncoder::encode_book(InstrumentId instrument, std::string_view data, std::string& out) {
+    thread_local BookUpdate update;
+    if (!BookDecoder::decode_book(data, update) && !BookDecoder::decode_book_generic(data, update)) {
+        return false;
+    }
+
+    size_t count = update.bids.size() + update.asks.size();
+    out.reserve(sizeof(Header) + sizeof(BookHeader) + count * sizeof(BookLevel));
+    append_header(out, Book, update.is_snapshot ? Snapshot : 0, instrument, count);
+    append_record(out, BookHeader{update.change_id, update.prev_change_id});
+
+    uint8_t side = 0;
+    for (const LevelBuffer* levels : {&update.bids, &update.asks}) {
+        for (size_t i = 0; i < levels->size(); ++i) {
+            BookLevel level{};
+            level.price = levels->prices[i];
+            level.amount = levels->amounts[i];
+            level.side = side;
+            level.action = levels->actions[i];
+            append_record(out, level);
+        }
+        ++side;
+    }
+    return true;
+}
+
+bool BinaryEncoder::encode_trades(InstrumentId instrument, std::string_view data, std::string& out) {
+    thread_local TradeBuffer trades;
+    if (!BookDecoder::decode_trades(data, trades)) {
+        return false;
+    }
+
+    out.reserve(sizeof(Header) + trades.size() * sizeof(TradeRecord));
+    append_header(out, Trades, 0, instrument, trades.size());
+    for (size_t i = 0; i < trades.size(); ++i) {
+        TradeRecord trade{};
+        trade.trade_seq = trades.trade_seqs[i];
+        trade.timestamp_ms = trades.timestamps[i];
+        trade.price = trades.prices[i];
+        trade.amount = trades.amounts[i];
+        trade.is_buy = trades.is_buy[i];
+        append_record(out, trade);
+    }
+    return true;
+}
+
+bool BinaryEncoder::encode_ticker(InstrumentId instrument, std::string_view data, std::string& out) {
+    nlohmann::json json = nlohmann::json::parse(data, nullptr, false);
+    if (!json.is_object()) {
+        return false;
+    }
+
+    TickerRecord ticker;
+    auto timestamp = json.find("timestamp");
+    ticker.timestamp_ms = timestamp != json.end() && timestamp->is_number_unsigned() ? timestamp->get<uint64_t>() : 0;
+    ticker.best_bid_price = number_or_nan(json, "best_bid_price");
+    ticker.best_bid_amount = number_or_nan(json, "best_bid_amount");
+    ticker.best_ask_price = number_or_nan(json, "best_ask_price");
+    ticker.best_ask_amount = number_or_nan(json, "best_ask_amount");
+    ticker.last_price = number_or_nan(json, "last_price");
+    ticker.mark_price = number_or_nan(json, "mark_price");
+    ticker.index_price = number_or_nan(json, "index_price");
+
+    append_header(out, Ticker, 0, instrument, 1);
+    append_record(out, ticker);
+    return true;
+}
@@ -0,0 +1,522 @@
+// BookDecoder.cpp
+
+#include "BookDecoder.hpp"
+#include "SubscriptionParser.hpp"
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <nlohmann/json.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BOOKDECODER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Powers of ten that are exact in a double; with a mantissa below 2^53 a single
+// multiply or divide is then correctly rounded (Clinger's fast path)
+const double kPow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+const int kMaxExactPow10 = 22;
+const uint64_t kMaxExactMantissa = uint64_t(1) << 53;
+const size_t kMaxFastDigits = 16;
+
+bool detect_avx2() {
+#ifdef BOOKDECODER_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+size_t count_digits_scalar(const char* p, const char* end) {
+    const char* start = p;
+    while (p < end && *p >= '0' && *p <= '9') {
+        ++p;
+    }
+    return p - start;
+}
+
+uint64_t digits_to_uint_scalar(const char* digits, size_t count) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < count; ++i) {
+        value = value * 10 + (digits[i] - '0');
+    }
+    return value;
+}
+
+#ifdef BOOKDECODER_X86
+// Length of the digit run at p, 32 bytes per step
+__attribute__((target("avx2")))
+size_t count_digits_avx2(const char* p, const char* end) {
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i nine = _mm256_set1_epi8(9);
+    size_t n = 0;
+    while (end - (p + n) >= 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + n));
+        // c - '0' <= 9 as unsigned bytes
+        __m256i offset = _mm256_sub_epi8(chunk, zero);
+        __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, nine), offset);
+        uint32_t non_digits = ~static_cast<uint32_t>(_mm256_movemask_epi8(is_digit));
+        if (non_digits) {
+            return n + __builtin_ctz(non_digits);
+        }
+        n += 32;
+    }
+    return n + count_digits_scalar(p + n, end);
+}
+
+// Convert exactly 16 ASCII digits: pairs, then groups of four, then two halves of eight
+__attribute__((target("avx2")))
+uint64_t digits16_to_uint_simd(const char* digits) {
+    __m128i chunk = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(digits)), _mm_set1_epi8('0'));
+    __m128i pairs = _mm_maddubs_epi16(chunk, _mm_set_epi8(1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10));
+    __m128i quads = _mm_madd_epi16(pairs, _mm_set_epi16(1, 100, 1, 100, 1, 100, 1, 100));
+    __m128i packed = _mm_packus_epi32(quads, quads);
+    __m128i halves = _mm_madd_epi16(packed, _mm_set_epi16(1, 10000, 1, 10000, 1, 10000, 1, 10000));
+    uint64_t high = static_cast<uint32_t>(_mm_cvtsi128_si32(halves));
+    uint64_t low = static_cast<uint32_t>(_mm_extract_epi32(halves, 1));
+    return high * 100000000 + low;
+}
+#endif
+
+size_t count_digits(const char* p, const char* end, bool simd) {
+#ifdef BOOKDECODER_X86
+    if (simd) {
+        return count_digits_avx2(p, end);
+    }
+#endif
+    (void)simd;
+    return count_digits_scalar(p, end);
+}
+
+// Mantissa of int_digits followed by frac_digits; total length is at most kMaxFastDigits
+uint64_t mantissa_to_uint(const char* int_digits, size_t int_len,
+                          const char* frac_digits, size_t frac_len, bool simd) {
+#ifdef BOOKDECODER_X86
+    if (simd) {
+        // Right-align the digits in a zero-padded block
+        char block[kMaxFastDigits];
+        std::memset(block, '0', sizeof(block));
+        std::memcpy(block + kMaxFastDigits - int_len - frac_len, int_digits, int_len);
+        std::memcpy(block + kMaxFastDigits - frac_len, frac_digits, frac_len);
+        return digits16_to_uint_simd(block);
+    }
+#endif
+    (void)simd;
+    uint64_t value = digits_to_uint_scalar(int_digits, int_len);
+    for (size_t i = 0; i < frac_len; ++i) {
+        value = value * 10 + (frac_digits[i] - '0');
+    }
+    return value;
+}
+
+std::atomic<bool>& simd_flag() {
+    static std::atomic<bool> enabled(detect_avx2());
+    return enabled;
+}
+
+} // namespace
+
+bool BookDecoder::simd_enabled() {
+    return simd_flag().load(std::memory_order_relaxed);
+}
+
+void BookDecoder::set_simd_enabled(bool enabled) {
+    simd_flag().store(enabled && detect_avx2(), std::memory_order_relaxed);
+}
+
+// Converts to the same double nlohmann::json yields: integers go through int64 and
+// floats through a correctly rounded strtod, both of which the exact fast path and
+// std::from_chars reproduce. The one special case is "-0", which nlohmann stores as
+// integer 0 and therefore reads back as +0.0.
+bool BookDecoder::parse_double(std::string_view data, size_t& pos, double& value) {
+    const bool simd = simd_enabled();
+    const char* begin = data.data() + pos;
+    const char* end = data.data() + data.size();
+    const char* p = begin;
+
+    bool negative = false;
+    if (p < end && *p == '-') {
+        negative = true;
+        ++p;
+    }
+
+    const char* int_digits = p;
+    size_t int_len = count_digits(p, end, simd);
+    if (int_len == 0) {
+        return false;
+    }
+    p += int_len;
+
+    bool is_integer = true;
+    const char* frac_digits = p;
+    size_t frac_len = 0;
+    if (p < end && *p == '.') {
+        is_integer = false;
+        frac_digits = ++p;
+        frac_len = count_digits(p, end, simd);
+        if (frac_len == 0) {
+            return false;
+        }
+        p += frac_len;
+    }
+
+    int exponent = 0;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        is_integer = false;
+        ++p;
+        bool negative_exponent = false;
+        if (p < end && (*p == '+' || *p == '-')) {
+            negative_exponent = *p == '-';
+            ++p;
+        }
+        size_t exp_len = count_digits_scalar(p, end);
+        if (exp_len == 0) {
+            return false;
+        }
+        for (size_t i = 0; i < exp_len; ++i) {
+            // Anything this large leaves the fast path anyway
+            if (exponent < 10000) {
+                exponent = exponent * 10 + (p[i] - '0');
+            }
+        }
+        p += exp_len;
+        if (negative_exponent) {
+            exponent = -exponent;
+        }
+    }
+
+    if (int_len + frac_len <= kMaxFastDigits) {
+        uint64_t mantissa = mantissa_to_uint(int_digits, int_len, frac_digits, frac_len, simd);
+        int exp10 = exponent - static_cast<int>(frac_len);
+        if (mantissa <= kMaxExactMantissa && exp10 >= -kMaxExactPow10 && exp10 <= kMaxExactPow10) {
+            double result = static_cast<double>(mantissa);
+            result = exp10 < 0 ? result / kPow10[-exp10] : result * kPow10[exp10];
+            if (negative && !(is_integer && mantissa == 0)) {
+                result = -result;
+            }
+            value = result;
+            pos = p - data.data();
+            return true;
+        }
+    }
+
+    double result = 0.0;
+    auto parsed = std::from_chars(begin, p, result);
+    if (parsed.ec != std::errc() || parsed.ptr != p) {
+        return false;
+    }
+    if (is_integer && result == 0.0) {
+        result = 0.0;
+    }
+    value = result;
+    pos = p - data.data();
+    return true;
+}
+
+bool BookDecoder::parse_uint(std::string_view data, size_t& pos, uint64_t& value) {
+    const char* begin = data.data() + pos;
+    const char* end = data.data() + data.size();
+    auto parsed = std::from_chars(begin, end, value);
+    if (parsed.ec != std::errc()) {
+        return false;
+    }
+    // Ids are plain integers; anything else goes to the generic parser
+    if (parsed.ptr < end && (*parsed.ptr == '.' || *parsed.ptr == 'e' || *parsed.ptr == 'E')) {
+        return false;
+    }
+    pos = parsed.ptr - data.data();
+    return true;
+}
+
+bool BookDecoder::decode_book(std::string_view data, BookUpdate& update) {
+    update.is_snapshot = false;
+    update.has_prev_change_id = false;
+    update.change_id = 0;
+    update.prev_change_id = 0;
+    update.bids.clear();
+    update.asks.clear();
+
+    size_t pos = 0;
+    SubscriptionParser::skip_whitespace(data, pos);
+    if (pos >= data.size() || data[pos] != '{') {
+        return false;
+    }
+    ++pos;
+
+    while (true) {
+        SubscriptionParser::skip_whitespace(data, pos);
+        if (pos >= data.size()) {
+            return false;
+        }
+        if (data[pos] == '}') {
+            return true;
+        }
+
+        std::string_view key;
+        if (!SubscriptionParser::read_plain_string(data, pos, key)) {
+            return false;
+        }
+        SubscriptionParser::skip_whitespace(data, pos);
+        if (pos >= data.size() || data[pos] != ':') {
+            return false;
+        }
+        ++pos;
+        SubscriptionParser::skip_whitespace(data, pos);
+
+        if (key == "bids") {
+            if (!decode_levels(data, pos, update.bids)) {
+                return false;
+            }
+        } else if (key == "asks") {
+            if (!decode_levels(data, pos, update.asks)) {
+                return false;
+            }
+        } else if (key == "change_id") {
+            if (!parse_uint(data, pos, update.change_id)) {
+                return false;
+            }
+        } else if (key == "prev_change_id") {
+            if (!parse_uint(data, pos, update.prev_change_id)) {
+                return false;
+            }
+            update.has_prev_change_id = true;
+        } else if (key == "type") {
+            std::string_view type;
+            if (!SubscriptionParser::read_plain_string(data, pos, type)) {
+                return false;
+            }
+            update.is_snapshot = type == "snapshot";
+        } else if (!SubscriptionParser::skip_value(data, pos)) {
+            return false;
+        }
+
+        SubscriptionParser::skip_whitespace(data, pos);
+        if (pos >= data.size()) {
+            return false;
+        }
+        if (data[pos] == ',') {
+            ++pos;
+        } else if (data[pos] != '}') {
+            return false;
+        }
+    }
+}
+
+// Slow path for payloads decode_book rejects (escaped strings, unexpected shapes)
+bool BookDecoder::decode_book_generic(std::string_view data, BookUpdate& update) {
+    update.bids.clear();
+    update.asks.clear();
+    try {
+        nlohmann::json json = nlohmann::json::parse(data);
+        update.change_id = json.value("change_id", uint64_t(0));
+        update.has_prev_change_id = json.contains("prev_change_id");
+        update.prev_change_id = json.value("prev_change_id", uint64_t(0));
+        update.is_snapshot = json.value("type", std::string()) == "snapshot";
+
+        for (const auto& side : {std::make_pair("bids", &update.bids), std::make_pair("asks", &update.asks)}) {
+            auto it = json.find(side.first);
+            if (it == json.end() || !it->is_array()) {
+                continue;
+            }
+            for (const auto& level : *it) {
+                // [action, price, amount]
+                if (level.size() < 3) {
+                    continue;
+                }
+                const std::string& action = level[0].get_ref<const std::string&>();
+                side.second->actions.push_back(action == "delete" ? LevelBuffer::Delete
+                                               : action == "change" ? LevelBuffer::Change
+                                               : LevelBuffer::New);
+                side.second->prices.push_back(level[1].get<double>());
+                side.second->amounts.push_back(level[2].get<double>());
+            }
+        }
+    } catch (const nlohmann::json::exception&) {
+        return false;
+    }
+    return true;
+}
+
+// [["new", price, amount], ...]
+bool BookDecoder::decode_levels(std::string_view data, size_t& pos, LevelBuffer& levels) {
+    if (pos >= data.size() || data[pos] != '[') {
+        return false;
+    }
+    ++pos;
+
+    while (true) {
+        SubscriptionParser::skip_whitespace(data, pos);
+        if (pos >= data.size()) {
+            return false;
+        }
+        if (data[pos] == ']') {
+            ++pos;
+            return true;
+        }
+        if (data[pos] != '[') {
+            return false;
+        }
+        ++pos;
+
+        std::string_view action_name;
+        SubscriptionParser::skip_whitespace(data, pos);
+        if (!SubscriptionParser::read_plain_string(data, pos, action_name)) {
+            return false;
+        }
+        uint8_t action;
+        if (action_name == "new") {
+            action = LevelBuffer::New;
+        } else if (action_name == "change") {
+            action = LevelBuffer::Change;
+        } else if (action_name == "delete") {
+            action = LevelBuffer::Delete;
+        } else {
+            return false;
+        }
+
+        double values[2];
+        for (double& v : values) {
+            SubscriptionParser::skip_whitespace(data, pos);
+            if (pos >= data.size() || data[pos] != ',') {
+                return false;
+            }
+            ++pos;
+            SubscriptionParser::skip_whitespace(data, pos);
+            if (!parse_double(data, pos, v)) {
+                return false;
+            }
+        }
+        SubscriptionParser::skip_whitespace(data, pos);
+        if (pos >= data.size() || data[pos] != ']') {
+            return false;
+        }
+        ++pos;
+
+        levels.actions.push_back(action);
+        levels.prices.push_back(values[0]);
+        levels.amounts.push_back(values[1]);
+
+        SubscriptionParser::skip_whitespace(data, pos);
+        if (pos >= data.size()) {
+            return false;
+        }
+        if (data[pos] == ',') {
+            ++pos;
+        } else if (data[pos] != ']') {
+            return false;
+        }
+    }
+}
+
+bool BookDecoder::decode_trades(std::string_view data, TradeBuffer& trades) {
+    trades.clear();
+
+    size_t pos = 0;
+    SubscriptionParser::skip_whitespace(data, pos);
+    if (pos >= data.size() || data[pos] != '[') {
+        return false;
+    }
+    ++pos;
+
+    while (true) {
+        SubscriptionParser::skip_whitespace(data, pos);
+        if (pos >= data.size()) {
+            return false;
+        }
+        if (data[pos] == ']') {
+            return true;
+        }
+        if (!decode_trade(data, pos, trades)) {
+            return false;
+        }
+
+        SubscriptionParser::skip_whitespace(data, pos);
+        if (pos >= data.size()) {
+            return false;
+        }
+        if (data[pos] == ',') {
+            ++pos;
+        } else if (data[pos] != ']') {
+            return false;
+        }
+    }
+}
+
+bool BookDecoder::decode_trade(std::string_view data, size_t& pos, TradeBuffer& trades) {
+    if (pos >= data.size() || data[pos] != '{') {
+        return false;
+    }
+    ++pos;
+
+    double price = 0.0;
+    double amount = 0.0;
+    bool is_buy = false;
+    uint64_t trade_seq = 0;
+    uint64_t timestamp = 0;
+
+    while (true) {
+        SubscriptionParser::skip_whitespace(data, pos);
+        if (pos >= data.size()) {
+            return false;
+        }
+        if (data[pos] == '}') {
+            ++pos;
+            break;
+        }
+
+        std::string_view key;
+        if (!SubscriptionParser::read_plain_string(data, pos, key)) {
+            return false;
+        }
+        SubscriptionParser::skip_whitespace(data, pos);
+        if (pos >= data.size() || data[pos] != ':') {
+            return false;
+        }
+        ++pos;
+        SubscriptionParser::skip_whitespace(data, pos);
+
+        bool ok;
+        if (key == "price") {
+            ok = parse_double(data, pos, price);
+        } else if (key == "amount") {
+            ok = parse_double(data, pos, amount);
+        } else if (key == "trade_seq") {
+            ok = parse_uint(data, pos, trade_seq);
+        } else if (key == "timestamp") {
+            ok = parse_uint(data, pos, timestamp);
+        } else if (key == "direction") {
+            std::string_view direction;
+            ok = SubscriptionParser::read_plain_string(data, pos, direction);
+            is_buy = direction == "buy";
+        } else {
+            ok = SubscriptionParser::skip_value(data, pos);
+        }
+        if (!ok) {
+            return false;
+        }
+
+        SubscriptionParser::skip_whitespace(data, pos);
+        if (pos >= data.size()) {
+            return false;
+        }
+        if (data[pos] == ',') {
+            ++pos;
+        } else if (data[pos] != '}') {
+            return false;
+        }
+    }
+
+    trades.prices.push_back(price);
+    trades.amounts.push_back(amount);
+    trades.is_buy.push_back(is_buy ? 1 : 0);
+    trades.trade_seqs.push_back(trade_seq);
+    trades.timestamps.push_back(timestamp);
+    return true;
+}
@@ -21,6 +21,35 @@ Config Config::load(const std::string& config_file) {
     config.rest_url = j.at("rest_url").get<std::string>();
     config.websocket_port = j.at("websocket_port").get<int>();
     config.log_file = j.at("log_file").get<std::string>();
+    config.market_data_queue_capacity = j.value("market_data_queue_capacity", size_t(65536));
+    config.market_data_conflation = j.value("market_data_conflation", false);
+    config.market_data_workers = j.value("market_data_workers", size_t(0));
+    config.ws_connections = j.value("ws_connections", size_t(1));
+    config.ws_shard_policy = j.value("ws_shard_policy", std::string("hash"));
+    config.ws_shard_assignments = j.value("ws_shard_assignments", std::unordered_map<std::string, size_t>());
+    config.ws_heartbeat_interval = j.value("ws_heartbeat_interval", 10);
+    config.ws_idle_probe_ms = j.value("ws_idle_probe_ms", 500);
+    config.ws_idle_timeout_ms = j.value("ws_idle_timeout_ms", 1500);
+    config.ws_reconnect_min_ms = j.value("ws_reconnect_min_ms", 50);
+    config.ws_reconnect_max_ms = j.value("ws_reconnect_max_ms", 5000);
+    config.ws_request_timeout_ms = j.value("ws_request_timeout_ms", 5000);
+    config.rest_connections = j.value("rest_connections", size_t(2));
+    config.rest_keepalive_ping_ms = j.value("rest_keepalive_ping_ms", 15000);
+    config.rest_async_max_connections = j.value("rest_async_max_connections", 4L);
+    config.rate_limit_matching_per_s = j.value("rate_limit_matching_per_s", 5.0);
+    config.rate_limit_matching_burst = j.value("rate_limit_matching_burst", 20.0);
+    config.rate_limit_non_matching_per_s = j.value("rate_limit_non_matching_per_s", 20.0);
+    config.rate_limit_non_matching_burst = j.value("rate_limit_non_matching_burst", 100.0);
+    config.rate_limit_cancel_reserve = j.value("rate_limit_cancel_reserve", 2.0);
+    config.rate_limit_max_queue_ms = j.value("rate_limit_max_queue_ms", 500);
+    config.order_journal_file = j.value("order_journal_file", std::string("order_journal.bin"));
+    config.order_journal_capacity = j.value("order_journal_capacity", size_t(65536));
+    config.position_reconcile_interval_s = j.value("position_reconcile_interval_s", 60);
+    config.websocket_io_threads = j.value("websocket_io_threads", size_t(1));
+    config.websocket_send_high_water_bytes = j.value("websocket_send_high_water_bytes", size_t(1048576));
+    config.websocket_send_queue_limit = j.value("websocket_send_queue_limit", size_t(1024));
+    config.websocket_slow_consumer_policy = j.value("websocket_slow_consumer_policy", std::string("drop_oldest"));
+    config.websocket_permessage_deflate = j.value("websocket_permessage_deflate", true);
     
     return config;
 }
@@ -0,0 +1,34 @@
+// ConflationBuffer.cpp
+
+#include "ConflationBuffer.hpp"
+
+void ConflationBuffer::update(ChannelId channel, std::string_view data) {
+    if (channel >= slots_.size()) {
+        slots_.resize(channel + 1);
+    }
+
+    Slot& slot = slots_[channel];
+    if (slot.dirty) {
+        // Superseded before it was delivered
+        ++conflated_;
+    } else {
+        slot.dirty = true;
+        dirty_slots_.push_back(channel);
+    }
+    // assign() reuses the slot's buffer once it has grown to the channel's usual size
+    slot.data.assign(data.data(), data.size());
+}
+
+void ConflationBuffer::drain(const DrainCallback& callback) {
+    // Taken out first, so a throwing callback loses the rest of this drain
+    // rather than delivering the slots before it again on the next one
+    draining_.clear();
+    draining_.swap(dirty_slots_);
+    for (ChannelId channel : draining_) {
+        slots_[channel].dirty = false;
+    }
+    for (ChannelId channel : draining_) {
+        callback(channel, slots_[channel].data);
+    }
+    draining_.clear();
+}
@@ -2,199 +2,543 @@
 
 #include "DeribitAPI.hpp"
 #include "Logger.hpp"
+#include "OrderEncoder.hpp"
+#include "SubscriptionParser.hpp"
 #include <curl/curl.h>
 #include <sstream>
 #include <openssl/hmac.h>
 #include <openssl/evp.h>
 #include <iostream>
 #include <future>
+#include <algorithm>
+#include <random>
 #include <boost/asio/ssl/context.hpp>
 #include <websocketpp/config/asio_client.hpp>
 #include <websocketpp/client.hpp>
 #include <nlohmann/json.hpp>
 
-// Helper function to write response data
-static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp)
-{
-    ((std::string*)userp)->append((char*)contents, size * nmemb);
-    return size * nmemb;
+// Orders use the first session; it is the one authenticated with public/auth
+static const size_t kOrderSession = 0;
+
+// Tokens are renewed after this fraction of their lifetime, leaving time to retry
+static const double kTokenRefreshFraction = 0.75;
+static const std::chrono::seconds kTokenRetryInterval(5);
+
+// A failed tick size fetch (e.g. a misspelt instrument) is retried no sooner than this
+static const std::chrono::seconds kTickSizeRetryInterval(30);
+
+static std::chrono::seconds token_refresh_delay(int expires_in) {
+    return std::chrono::seconds(static_cast<int64_t>(expires_in * kTokenRefreshFraction));
+}
+
+// Deribit's too_many_requests; also used for requests shed by the local rate limiter
+static const int kTooManyRequests = 10028;
+
+static const char* const kShedMessage = "too_many_requests (shed by client rate limiter)";
+
+static nlohmann::json shed_error() {
+    return {{"error", {{"code", kTooManyRequests}, {"message", kShedMessage}}}};
+}
+
+// A too_many_requests that came from the exchange rather than from shed_error()
+static bool is_exchange_throttle(const nlohmann::json& response) {
+    return response.is_object() && response.contains("error") && response["error"].is_object() &&
+           response["error"].value("code", 0) == kTooManyRequests &&
+           response["error"].value("message", "") != kShedMessage;
+}
+
+// What is safe to log about an RPC frame: its id, method and error. Results are
+// left out since public/auth results carry the access and refresh tokens.
+static std::string describe_rpc(const nlohmann::json& message) {
+    std::string text = "id=" + (message.contains("id") ? message["id"].dump() : std::string("none"));
+    if (message.contains("method")) {
+        text += " method=" + message["method"].dump();
+    }
+    if (message.contains("error")) {
+        text += " error=" + message["error"].dump();
+    }
+    return text;
+}
+
+static int64_t steady_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
+// Collects the per-session responses of one batched subscribe/unsubscribe
+struct SubscriptionBatch {
+    std::mutex mtx;
+    size_t remaining = 0;
+    std::vector<std::string> channels;
+    std::promise<std::vector<std::string>> promise;
+
+    void complete(const std::vector<std::string>& accepted) {
+        std::lock_guard<std::mutex> lock(mtx);
+        channels.insert(channels.end(), accepted.begin(), accepted.end());
+        if (--remaining == 0) {
+            promise.set_value(channels);
+        }
+    }
+};
+
 // Constructor
 DeribitAPI::DeribitAPI(const std::string& api_key, const std::string& api_secret,
-                       const std::string& rest_url, const std::string& websocket_url)
+                       const std::string& rest_url, const std::string& websocket_url,
+                       const DeribitOptions& options)
     : api_key_(api_key), api_secret_(api_secret), rest_url_(rest_url), websocket_url_(websocket_url),
-      access_token_(""), ws_connected_(false), ws_client_(), ws_thread_() {
+      options_(options), running_(true), next_request_id_(1),
+      dispatcher_(std::max<size_t>(options.ws_connections, 1), options.market_data_queue_capacity,
+                  std::bind(&DeribitAPI::on_rpc_message, this, std::placeholders::_1),
+                  options.market_data_conflation, options.market_data_workers) {
     curl_global_init(CURL_GLOBAL_DEFAULT);
 
-    // Initialize WebSocket client
-    ws_client_.init_asio();
+    // Open the REST connections now so the first order does not pay for the handshake
+    rest_pool_ = std::make_unique<RestConnectionPool>(rest_url_, options_.rest_connections,
+                                                      options_.rest_keepalive_ping_ms);
+    rest_pool_->warm_up();
+    async_rest_ = std::make_unique<AsyncRestClient>(rest_url_, options_.rest_async_max_connections,
+                                                    options_.request_timeout_ms);
+    rate_limiter_ = std::make_unique<RateLimiter>(
+        RateLimiter::Limits{options_.matching_engine_rate, options_.matching_engine_burst},
+        RateLimiter::Limits{options_.non_matching_rate, options_.non_matching_burst},
+        options_.cancel_reserve, options_.rate_limit_max_queue_ms);
+
+    // Start the consumer that parses and dispatches received frames
+    dispatcher_.start();
+
+    // One TLS context for every connection and reconnect
+    init_tls_context();
 
-    // Optional: Configure logging settings
-    ws_client_.clear_access_channels(websocketpp::log::alevel::all);
-    ws_client_.clear_error_channels(websocketpp::log::elevel::all);
+    size_t session_count = std::max<size_t>(options_.ws_connections, 1);
+    for (size_t i = 0; i < session_count; ++i) {
+        auto session = std::make_unique<WsSession>();
+        session->index = i;
 
-    // Set Global TLS initialization handler
-    ws_client_.set_tls_init_handler(std::bind(&DeribitAPI::on_tls_init, this, std::placeholders::_1));
+        // Initialize WebSocket client
+        session->client.init_asio();
 
-    // Start WebSocket connection thread
-    ws_thread_ = std::thread(&DeribitAPI::init_deribit_connection, this);
+        // Optional: Configure logging settings
+        session->client.clear_access_channels(websocketpp::log::alevel::all);
+        session->client.clear_error_channels(websocketpp::log::elevel::all);
+
+        // Set Global TLS initialization handler
+        session->client.set_tls_init_handler(std::bind(&DeribitAPI::on_tls_init, this, std::placeholders::_1));
+
+        // Offer the previous TLS session on reconnect
+        session->client.set_socket_init_handler(std::bind(&DeribitAPI::on_socket_init, this, std::ref(*session),
+                                                          std::placeholders::_1, std::placeholders::_2));
+
+        sessions_.push_back(std::move(session));
+    }
+
+    // Start one connection thread per session
+    for (auto& session : sessions_) {
+        session->thread = std::thread(&DeribitAPI::init_deribit_connection, this, std::ref(*session));
+    }
+
+    token_refresh_thread_ = std::thread(&DeribitAPI::run_token_refresh, this);
 }
 
 // Destructor
 DeribitAPI::~DeribitAPI() {
-    // Close WebSocket connection gracefully
     {
-        std::lock_guard<std::mutex> lock(ws_mtx_);
-        if (ws_connected_) {
-            websocketpp::lib::error_code ec;
-            ws_client_.close(ws_hdl_, websocketpp::close::status::normal, "Shutting down", ec);
-            if (ec) {
-                Logger::getInstance().log("Error closing WebSocket: " + ec.message());
+        std::lock_guard<std::mutex> lock(token_refresh_mtx_);
+        running_ = false;
+    }
+    token_refresh_cv_.notify_all();
+    if (token_refresh_thread_.joinable()) {
+        token_refresh_thread_.join();
+    }
+
+    // Fail requests still waiting for rate limit credit while the transports are up
+    rate_limiter_.reset();
+
+    for (auto& session : sessions_) {
+        // Close WebSocket connection gracefully
+        {
+            std::lock_guard<std::mutex> lock(session->mtx);
+            if (session->connected) {
+                websocketpp::lib::error_code ec;
+                session->client.close(session->hdl, websocketpp::close::status::normal, "Shutting down", ec);
+                if (ec) {
+                    Logger::getInstance().log("Error closing WebSocket: " + ec.message());
+                }
+                session->connected = false;
             }
-            ws_connected_ = false;
+        }
+
+        // Stop ASIO loop
+        session->client.stop();
+    }
+
+    // Join WebSocket threads
+    for (auto& session : sessions_) {
+        if (session->thread.joinable()) {
+            session->thread.join();
         }
     }
 
-    // Stop ASIO loop
-    ws_client_.stop();
+    // Stop dispatching once no more frames can arrive
+    dispatcher_.stop();
 
-    // Join WebSocket thread
-    if (ws_thread_.joinable()) {
-        ws_thread_.join();
+    for (auto& session : sessions_) {
+        if (session->tls_session) {
+            SSL_SESSION_free(session->tls_session);
+        }
     }
 
+    async_rest_.reset();
+    rest_pool_.reset();
     curl_global_cleanup();
 }
 
 // Initialize Deribit Connection
-void DeribitAPI::init_deribit_connection() {
-    while (true) { // Loop to handle reconnection attempts
+void DeribitAPI::init_deribit_connection(WsSession& session) {
+    std::string tag = "[session " + std::to_string(session.index) + "] ";
+    std::mt19937 rng(std::random_device{}());
+    int backoff_ms = options_.reconnect_min_ms;
+
+    while (running_) { // Loop to handle reconnection attempts
         websocketpp::lib::error_code ec;
+        session.opened = false;
 
-        Logger::getInstance().log("Attempting WebSocket connection to: " + websocket_url_);
+        Logger::getInstance().log(tag + "Attempting WebSocket connection to: " + websocket_url_);
 
         // Create a new connection
-        WsClient::connection_ptr con = ws_client_.get_connection(websocket_url_, ec);
-        if (ec) {
-            Logger::getInstance().log("WebSocket connection creation failed: " + ec.message());
-            std::this_thread::sleep_for(std::chrono::seconds(5));
-            continue; // Retry after delay
-        }
+        WsClient::connection_ptr con = session.client.get_connection(websocket_url_, ec);
+        if (!ec) {
+            // Since the global TLS handler is already set, no need to set it again per connection
 
-        // Since the global TLS handler is already set, no need to set it again per connection
+            // Set Open Handler
+            con->set_open_handler(std::bind(&DeribitAPI::on_ws_open, this, std::ref(session), std::placeholders::_1));
 
-        // Set Open Handler
-        con->set_open_handler(std::bind(&DeribitAPI::on_ws_open, this, std::placeholders::_1));
+            // Set Fail Handler
+            con->set_fail_handler(std::bind(&DeribitAPI::on_ws_fail, this, std::ref(session), std::placeholders::_1));
 
-        // Set Fail Handler
-        con->set_fail_handler(std::bind(&DeribitAPI::on_ws_fail, this, std::placeholders::_1));
+            // Set Close Handler
+            con->set_close_handler(std::bind(&DeribitAPI::on_ws_close, this, std::ref(session), std::placeholders::_1));
 
-        // Set Close Handler
-        con->set_close_handler(std::bind(&DeribitAPI::on_ws_close, this, std::placeholders::_1));
+            // Set Message Handler
+            con->set_message_handler(std::bind(&DeribitAPI::on_ws_message, this, std::ref(session), std::placeholders::_1, std::placeholders::_2));
 
-        // Set Message Handler
-        con->set_message_handler(std::bind(&DeribitAPI::on_ws_message, this, std::placeholders::_1, std::placeholders::_2));
+            // Initiate the connection
+            session.client.connect(con);
+            Logger::getInstance().log(tag + "WebSocket connection initiated.");
 
-        // Initiate the connection
-        ws_client_.connect(con);
-        Logger::getInstance().log("WebSocket connection initiated.");
+            // Run the ASIO io_service loop (blocking call)
+            try {
+                session.client.run();
+            } catch (const std::exception& e) {
+                Logger::getInstance().log(tag + "WebSocket client exception: " + e.what());
+            }
+        } else {
+            Logger::getInstance().log(tag + "WebSocket connection creation failed: " + ec.message());
+        }
 
-        // Run the ASIO io_service loop (blocking call)
-        try {
-            ws_client_.run();
-        } catch (const std::exception& e) {
-            Logger::getInstance().log(std::string("WebSocket client exception: ") + e.what());
-            // Wait before retrying
-            std::this_thread::sleep_for(std::chrono::seconds(5));
+        if (!running_) {
+            break;
         }
 
-        // If run() exits, loop will attempt to reconnect
+        // run() has returned; the io_service must be restarted before the next connect
+        session.client.reset();
+
+        // Jittered exponential backoff, restarting from the minimum after a connection
+        // that actually opened so a single drop reconnects within milliseconds
+        if (session.opened) {
+            backoff_ms = options_.reconnect_min_ms;
+        }
+        std::uniform_int_distribution<int> jitter(backoff_ms / 2, backoff_ms);
+        int delay_ms = jitter(rng);
+        Logger::getInstance().log(tag + "Reconnecting in " + std::to_string(delay_ms) + " ms.");
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+        backoff_ms = std::min(backoff_ms * 2, options_.reconnect_max_ms);
     }
 }
 
-// TLS initialization handler
-std::shared_ptr<boost::asio::ssl::context> DeribitAPI::on_tls_init(connection_hdl /*hdl*/) {
-    auto ctx = std::make_shared<boost::asio::ssl::context>(boost::asio::ssl::context::tlsv12_client);
+// Pick the upstream session that carries a channel.
+// All channels of one instrument land on the same session, so per-channel (and
+// per-instrument) ordering survives the merge in the dispatcher. With more than
+// one session, market data stays off the order session so acks never share its
+// socket with book traffic.
+DeribitAPI::WsSession& DeribitAPI::session_for(const std::string& channel) {
+    if (sessions_.size() == 1) {
+        return *sessions_[0];
+    }
+
+    const InstrumentRegistry& registry = InstrumentRegistry::getInstance();
+    ChannelId id = registry.find_channel(channel);
+    std::string_view instrument = channel;
+    if (id != kInvalidId && registry.channel_instrument(id) != kInvalidId) {
+        instrument = registry.instrument_name(registry.channel_instrument(id));
+    }
+
+    if (options_.shard_policy == ShardPolicy::Explicit) {
+        auto it = options_.shard_assignments.find(std::string(instrument));
+        if (it != options_.shard_assignments.end() && it->second != kOrderSession && it->second < sessions_.size()) {
+            return *sessions_[it->second];
+        }
+    }
+    // The order session is the first; the others carry market data
+    return *sessions_[1 + std::hash<std::string_view>()(instrument) % (sessions_.size() - 1)];
+}
+
+// Send a text frame on a session; fails if the session is not connected
+bool DeribitAPI::send_ws(WsSession& session, std::string_view message) {
+    std::lock_guard<std::mutex> lock(session.mtx);
+    if (!session.connected) {
+        return false;
+    }
+    websocketpp::lib::error_code ec;
+    session.client.send(session.hdl, message.data(), message.size(), websocketpp::frame::opcode::text, ec);
+    if (ec) {
+        Logger::getInstance().log("[session " + std::to_string(session.index) + "] WebSocket send failed: " + ec.message());
+        return false;
+    }
+    return true;
+}
+
+// Build the TLS context once; every connection and reconnect shares it
+void DeribitAPI::init_tls_context() {
+    tls_ctx_ = std::make_shared<boost::asio::ssl::context>(boost::asio::ssl::context::tlsv12_client);
 
     try {
-        ctx->set_options(boost::asio::ssl::context::default_workarounds |
-                         boost::asio::ssl::context::no_sslv2 |
-                         boost::asio::ssl::context::no_sslv3 |
-                         boost::asio::ssl::context::single_dh_use);
+        tls_ctx_->set_options(boost::asio::ssl::context::default_workarounds |
+                              boost::asio::ssl::context::no_sslv2 |
+                              boost::asio::ssl::context::no_sslv3 |
+                              boost::asio::ssl::context::single_dh_use);
 
         // For production, verify the peer
-        ctx->set_verify_mode(boost::asio::ssl::verify_peer);
-        ctx->set_default_verify_paths();
+        tls_ctx_->set_verify_mode(boost::asio::ssl::verify_peer);
+        tls_ctx_->set_default_verify_paths();
+
+        // Keep client sessions so reconnects can resume instead of doing a full handshake
+        SSL_CTX_set_session_cache_mode(tls_ctx_->native_handle(), SSL_SESS_CACHE_CLIENT);
 
         Logger::getInstance().log("TLS context initialized successfully.");
     } catch (const std::exception& e) {
         Logger::getInstance().log("TLS Initialization failed: " + std::string(e.what()));
     }
+}
 
-    return ctx;
+// TLS initialization handler
+std::shared_ptr<boost::asio::ssl::context> DeribitAPI::on_tls_init(connection_hdl /*hdl*/) {
+    return tls_ctx_;
 }
 
-// WebSocket event handlers
-void DeribitAPI::on_ws_open(connection_hdl hdl) {
+// Runs before the handshake: offer the session saved from the previous connection
+void DeribitAPI::on_socket_init(WsSession& session, connection_hdl /*hdl*/,
+                                boost::asio::ssl::stream<boost::asio::ip::tcp::socket>& stream) {
+    if (session.tls_session) {
+        SSL_set_session(stream.native_handle(), session.tls_session);
+    }
+}
+
+void DeribitAPI::save_tls_session(WsSession& session, connection_hdl hdl) {
+    websocketpp::lib::error_code ec;
+    WsClient::connection_ptr con = session.client.get_con_from_hdl(hdl, ec);
+    if (ec || !con) {
+        return;
+    }
+    SSL_SESSION* tls_session = SSL_get1_session(con->get_socket().native_handle());
+    if (!tls_session) {
+        return;
+    }
+    if (session.tls_session) {
+        SSL_SESSION_free(session.tls_session);
+    }
+    session.tls_session = tls_session;
+}
+
+void DeribitAPI::schedule_liveness_check(WsSession& session, connection_hdl hdl) {
+    // Check a few times per probe interval so detection stays well under a second
+    long interval_ms = std::max(options_.idle_probe_ms / 4, 10);
+    session.watchdog = session.client.set_timer(interval_ms,
+        std::bind(&DeribitAPI::check_liveness, this, std::ref(session), hdl, std::placeholders::_1));
+}
+
+// Timer handler on the session's io thread: probe a quiet link with public/test and
+// drop it if nothing at all arrives within idle_timeout_ms
+void DeribitAPI::check_liveness(WsSession& session, connection_hdl hdl, const websocketpp::lib::error_code& ec) {
+    if (ec || !running_) {
+        return;
+    }
     {
-        std::lock_guard<std::mutex> lock(ws_mtx_);
-        ws_hdl_ = hdl;
-        ws_connected_ = true;
+        std::lock_guard<std::mutex> lock(session.mtx);
+        bool same_connection = !session.hdl.owner_before(hdl) && !hdl.owner_before(session.hdl);
+        if (!session.connected || !same_connection) {
+            return;
+        }
     }
-    Logger::getInstance().log("WebSocket connection established.");
 
-    // Resubscribe to previously subscribed channels
-    std::lock_guard<std::mutex> lock(subscription_mtx_);
-    for (const auto& channel : subscribed_channels_) {
-        if (!subscribe(channel)) {
-            Logger::getInstance().log("Resubscription failed for channel: " + channel);
-        } else {
-            Logger::getInstance().log("Resubscribed to channel: " + channel);
+    // A lost or unanswered response must not leave its caller waiting forever
+    fail_pending_requests(session.index, "Request timed out", true);
+
+    int64_t idle_ms = (steady_now_ns() - session.last_rx_ns.load()) / 1000000;
+    if (idle_ms > options_.idle_timeout_ms) {
+        Logger::getInstance().log("[session " + std::to_string(session.index) + "] No data for " +
+                                  std::to_string(idle_ms) + " ms, dropping connection.");
+        websocketpp::lib::error_code close_ec;
+        WsClient::connection_ptr con = session.client.get_con_from_hdl(hdl, close_ec);
+        if (con) {
+            // Closing the socket aborts pending I/O at once instead of waiting for a close handshake
+            boost::system::error_code socket_ec;
+            con->get_raw_socket().close(socket_ec);
+        }
+        return;
+    }
+
+    if (idle_ms > options_.idle_probe_ms && !session.probe_outstanding.exchange(true)) {
+        bool sent = send_rpc(session, "public/test", nlohmann::json::object(), [&session](const nlohmann::json&) {
+            session.probe_outstanding = false;
+        });
+        if (!sent) {
+            session.probe_outstanding = false;
         }
     }
+
+    schedule_liveness_check(session, hdl);
 }
 
-void DeribitAPI::on_ws_close(connection_hdl hdl) {
+// WebSocket event handlers
+void DeribitAPI::on_ws_open(WsSession& session, connection_hdl hdl) {
+    {
+        std::lock_guard<std::mutex> lock(session.mtx);
+        session.hdl = hdl;
+        session.connected = true;
+    }
+    session.opened = true;
+    session.last_rx_ns = steady_now_ns();
+    session.probe_outstanding = false;
+    Logger::getInstance().log("[session " + std::to_string(session.index) + "] WebSocket connection established.");
+
+    save_tls_session(session, hdl);
+
+    // Ask the exchange for heartbeats and watch the link ourselves between them
+    bool heartbeat_sent = send_rpc(session, "public/set_heartbeat", {{"interval", options_.heartbeat_interval_s}},
+        [](const nlohmann::json& response) {
+            if (!response.contains("result")) {
+                Logger::getInstance().log("public/set_heartbeat failed: " + response.dump());
+            }
+        });
+    if (!heartbeat_sent) {
+        Logger::getInstance().log("public/set_heartbeat could not be sent on session " + std::to_string(session.index));
+    }
+    schedule_liveness_check(session, hdl);
+
+    if (session.index == kOrderSession) {
+        authenticate_ws(session);
+    }
+
+    // Resubscribe to the channels previously accepted on this session in one request
+    std::vector<std::string> channels;
     {
-        std::lock_guard<std::mutex> lock(ws_mtx_);
-        ws_connected_ = false;
+        std::lock_guard<std::mutex> lock(subscription_mtx_);
+        channels.assign(session.channels.begin(), session.channels.end());
+    }
+    if (channels.empty()) {
+        return;
     }
-    Logger::getInstance().log("WebSocket connection closed.");
-    // After ws_client_.run() exits, the loop will attempt to reconnect
+
+    size_t requested = channels.size();
+    bool sent = send_rpc(session, "public/subscribe", {{"channels", channels}},
+        [requested](const nlohmann::json& response) {
+            if (response.contains("result") && response["result"].is_array()) {
+                Logger::getInstance().log("Resubscribed to " + std::to_string(response["result"].size()) +
+                                          " of " + std::to_string(requested) + " channels.");
+            } else {
+                Logger::getInstance().log("Resubscription failed: " + response.dump());
+            }
+        });
+    if (!sent) {
+        Logger::getInstance().log("Resubscription request could not be sent on session " + std::to_string(session.index));
+    }
+}
+
+void DeribitAPI::on_ws_close(WsSession& session, connection_hdl hdl) {
+    {
+        std::lock_guard<std::mutex> lock(session.mtx);
+        session.connected = false;
+    }
+    session.authenticated = false;
+    // TLS 1.3 tickets arrive after the handshake, so refresh the saved session now
+    save_tls_session(session, hdl);
+    Logger::getInstance().log("[session " + std::to_string(session.index) + "] WebSocket connection closed.");
+    fail_pending_requests(session.index, "WebSocket connection closed");
+    // After client.run() exits, the loop will attempt to reconnect
 }
 
-void DeribitAPI::on_ws_fail(connection_hdl hdl) {
+void DeribitAPI::on_ws_fail(WsSession& session, connection_hdl /*hdl*/) {
     {
-        std::lock_guard<std::mutex> lock(ws_mtx_);
-        ws_connected_ = false;
+        std::lock_guard<std::mutex> lock(session.mtx);
+        session.connected = false;
     }
-    Logger::getInstance().log("Failed to connect to Deribit WebSocket.");
-    // After ws_client_.run() exits, the loop will attempt to reconnect
+    Logger::getInstance().log("[session " + std::to_string(session.index) + "] Failed to connect to Deribit WebSocket.");
+    fail_pending_requests(session.index, "WebSocket connection failed");
+    // After client.run() exits, the loop will attempt to reconnect
 }
 
-void DeribitAPI::on_ws_message(connection_hdl hdl, message_ptr msg) {
-    std::string payload = msg->get_payload();
-    Logger::getInstance().log("Received WebSocket message: " + payload);
+// Each session runs one connection at a time, so every frame belongs to the current one
+void DeribitAPI::on_ws_message(WsSession& session, connection_hdl /*hdl*/, message_ptr msg) {
+    session.last_rx_ns.store(steady_now_ns(), std::memory_order_relaxed);
 
+    // Answer exchange heartbeats right here so they never wait behind market data.
+    // They are tiny, so the size check keeps this off the path of real updates.
+    const std::string& payload = msg->get_payload();
+    if (payload.size() < 256 && payload.find("\"test_request\"") != std::string::npos) {
+        send_rpc(session, "public/test", nlohmann::json::object(), RpcCallback());
+        return;
+    }
+
+    // Only hand the frame off here; parsing and callbacks run on the dispatcher
+    // thread so a slow consumer never stalls socket reads. Each session owns one
+    // ring of the dispatcher. Responses bypass the rings, which drop frames when full.
+    if (SubscriptionParser::is_response(payload)) {
+        dispatcher_.enqueue_response(std::move(msg->get_raw_payload()));
+        return;
+    }
+    dispatcher_.enqueue(session.index, std::move(msg->get_raw_payload()));
+}
+
+// Frames the dispatcher's subscription fast path did not handle
+void DeribitAPI::on_rpc_message(const std::string& payload) {
     try {
         auto json_msg = nlohmann::json::parse(payload);
 
+        // Complete the request this is a response to, if we are waiting for it
+        if (json_msg.contains("id") && json_msg["id"].is_number_unsigned()) {
+            RpcCallback callback;
+            {
+                std::lock_guard<std::mutex> lock(pending_mtx_);
+                auto it = pending_requests_.find(json_msg["id"].get<uint64_t>());
+                if (it != pending_requests_.end()) {
+                    callback = std::move(it->second.callback);
+                    pending_requests_.erase(it);
+                }
+            }
+            if (callback) {
+                callback(json_msg);
+                return;
+            }
+        }
+
         if (json_msg.contains("method") && json_msg["method"] == "subscription") {
-            // Process real-time market data
+            // Process real-time market data the fast path could not handle
             std::string channel = json_msg["params"]["channel"].get<std::string>();
             nlohmann::json data = json_msg["params"]["data"];
 
             // Invoke the user-defined callback
-            if (message_callback_) {
-                message_callback_(channel, data.dump());
+            ChannelId channel_id = InstrumentRegistry::getInstance().intern_channel(channel);
+            if (channel_id != kInvalidId) {
+                std::string data_text = data.dump();
+                dispatcher_.dispatch(channel_id, data_text);
             }
         } else if (json_msg.contains("result")) {
-            // Handle successful subscription or other results
-            Logger::getInstance().log("Subscription successful or received result: " + json_msg.dump());
+            // A result nobody is waiting for any more
+            Logger::getInstance().log("Unclaimed WebSocket result: " + describe_rpc(json_msg));
         } else if (json_msg.contains("error")) {
-            // Handle errors
-            Logger::getInstance().log("WebSocket error: " + json_msg.dump());
+            Logger::getInstance().log("WebSocket error: " + describe_rpc(json_msg));
+        } else {
+            Logger::getInstance().log("Unhandled WebSocket message: " + describe_rpc(json_msg));
         }
     } catch (const std::exception& e) {
         Logger::getInstance().log("WebSocket message parse error: " + std::string(e.what()));
@@ -203,154 +547,489 @@ void DeribitAPI::on_ws_message(connection_hdl hdl, message_ptr msg) {
 
 // Set the callback for incoming market data
 void DeribitAPI::set_message_callback(MessageCallback callback) {
-    message_callback_ = callback;
+    dispatcher_.set_message_callback(callback);
 }
 
-// Subscribe to a Deribit channel
-bool DeribitAPI::subscribe(const std::string& channel) {
-    std::lock_guard<std::mutex> lock(subscription_mtx_);
-    if (subscribed_channels_.find(channel) != subscribed_channels_.end()) {
-        // Already subscribed
-        return true;
-    }
+void DeribitAPI::add_user_callback(MessageCallback callback) {
+    dispatcher_.add_user_callback(callback);
+}
 
-    if (!ws_connected_) {
-        Logger::getInstance().log("WebSocket not connected. Cannot subscribe to channel: " + channel);
-        return false;
-    }
+MarketDataDispatcher::Stats DeribitAPI::get_market_data_stats() const {
+    return dispatcher_.get_stats();
+}
+
+RateLimiter::Stats DeribitAPI::get_rate_limit_stats() const {
+    return rate_limiter_->get_stats();
+}
 
-    // Create JSON-RPC subscribe request
-    nlohmann::json subscribe_request = {
+// Send a JSON-RPC request on a session with a fresh id; the callback runs on the
+// dispatcher thread when the matching result/error arrives, or with an error if
+// the connection drops or request_timeout_ms passes first
+bool DeribitAPI::send_rpc(WsSession& session, const std::string& method, const nlohmann::json& params, RpcCallback callback) {
+    uint64_t id = next_request_id_.fetch_add(1);
+    nlohmann::json request = {
         {"jsonrpc", "2.0"},
-        {"id", 1}, // Consider implementing dynamic IDs for multiple requests
-        {"method", "public/subscribe"},
-        {"params", {
-            {"channels", {channel}}
-        }}
+        {"id", id},
+        {"method", method},
+        {"params", params}
     };
+    return send_rpc_encoded(session, id, request.dump(), std::move(callback));
+}
 
-    std::string message = subscribe_request.dump();
+// message is a complete JSON-RPC request carrying id
+bool DeribitAPI::send_rpc_encoded(WsSession& session, uint64_t id, std::string_view message, RpcCallback callback) {
+    {
+        std::lock_guard<std::mutex> lock(pending_mtx_);
+        int64_t deadline_ns = steady_now_ns() + int64_t(options_.request_timeout_ms) * 1000000;
+        pending_requests_[id] = PendingRequest{session.index, deadline_ns, std::move(callback)};
+    }
 
-    // Send the subscribe message
-    websocketpp::lib::error_code ec;
-    ws_client_.send(ws_hdl_, message, websocketpp::frame::opcode::text, ec);
-    if (ec) {
-        Logger::getInstance().log("Failed to send subscribe message: " + ec.message());
+    if (!send_ws(session, message)) {
+        std::lock_guard<std::mutex> lock(pending_mtx_);
+        pending_requests_.erase(id);
         return false;
     }
-
-    subscribed_channels_.insert(channel);
-    Logger::getInstance().log("Subscribed to Deribit channel: " + channel);
     return true;
 }
 
-// Unsubscribe from a Deribit channel
-bool DeribitAPI::unsubscribe(const std::string& channel) {
-    std::lock_guard<std::mutex> lock(subscription_mtx_);
-    if (subscribed_channels_.find(channel) == subscribed_channels_.end()) {
-        // Not subscribed
-        return true;
-    }
-
-    if (!ws_connected_) {
-        Logger::getInstance().log("WebSocket not connected. Cannot unsubscribe from channel: " + channel);
-        return false;
+// Fails a session's requests that are still waiting: all of them, or with
+// expired_only just those past their deadline. The callbacks get an error response.
+void DeribitAPI::fail_pending_requests(size_t session, const std::string& reason, bool expired_only) {
+    int64_t now_ns = steady_now_ns();
+    std::vector<RpcCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(pending_mtx_);
+        for (auto it = pending_requests_.begin(); it != pending_requests_.end();) {
+            if (it->second.session == session && (!expired_only || it->second.deadline_ns <= now_ns)) {
+                callbacks.push_back(std::move(it->second.callback));
+                it = pending_requests_.erase(it);
+            } else {
+                ++it;
+            }
+        }
     }
 
-    // Create JSON-RPC unsubscribe request
-    nlohmann::json unsubscribe_request = {
-        {"jsonrpc", "2.0"},
-        {"id", 1},
-        {"method", "public/unsubscribe"},
-        {"params", {
-            {"channels", {channel}}
+    nlohmann::json error = {
+        {"error", {
+            {"message", reason}
         }}
     };
+    for (auto& callback : callbacks) {
+        if (callback) {
+            callback(error);
+        }
+    }
+}
 
-    std::string message = unsubscribe_request.dump();
+// Subscribe to a Deribit channel; the batch completes by the request deadline
+bool DeribitAPI::subscribe(const std::string& channel) {
+    auto accepted = subscribe(std::vector<std::string>{channel}).get();
+    return std::find(accepted.begin(), accepted.end(), channel) != accepted.end();
+}
 
-    // Send the unsubscribe message
-    websocketpp::lib::error_code ec;
-    ws_client_.send(ws_hdl_, message, websocketpp::frame::opcode::text, ec);
-    if (ec) {
-        Logger::getInstance().log("Failed to send unsubscribe message: " + ec.message());
-        return false;
+// Unsubscribe from a Deribit channel
+bool DeribitAPI::unsubscribe(const std::string& channel) {
+    auto removed = unsubscribe(std::vector<std::string>{channel}).get();
+    return std::find(removed.begin(), removed.end(), channel) != removed.end();
+}
+
+std::future<std::vector<std::string>> DeribitAPI::subscribe(const std::vector<std::string>& channels) {
+    return update_subscriptions(channels, true);
+}
+
+std::future<std::vector<std::string>> DeribitAPI::unsubscribe(const std::vector<std::string>& channels) {
+    return update_subscriptions(channels, false);
+}
+
+// Batch subscribe/unsubscribe: channels are grouped by session and each group is
+// sent as a single public/subscribe or public/unsubscribe request
+std::future<std::vector<std::string>> DeribitAPI::update_subscriptions(const std::vector<std::string>& channels, bool subscribe) {
+    auto batch = std::make_shared<SubscriptionBatch>();
+    auto future = batch->promise.get_future();
+
+    std::vector<std::vector<std::string>> by_session(sessions_.size());
+    std::vector<std::string> unchanged;
+    {
+        std::lock_guard<std::mutex> lock(subscription_mtx_);
+        for (const auto& channel : channels) {
+            if (subscribe) {
+                // Assign the channel its id before any notification for it can arrive
+                InstrumentRegistry::getInstance().intern_channel(channel);
+            }
+            WsSession& session = session_for(channel);
+            bool active = session.channels.find(channel) != session.channels.end();
+            if (active == subscribe) {
+                // Already in the requested state
+                unchanged.push_back(channel);
+            } else {
+                by_session[session.index].push_back(channel);
+            }
+        }
     }
 
-    subscribed_channels_.erase(channel);
-    Logger::getInstance().log("Unsubscribed from Deribit channel: " + channel);
-    return true;
+    size_t requests = 0;
+    for (const auto& group : by_session) {
+        if (!group.empty()) {
+            ++requests;
+        }
+    }
+    batch->remaining = requests + 1;
+    batch->complete(unchanged);
+
+    std::string method = subscribe ? "public/subscribe" : "public/unsubscribe";
+    for (size_t i = 0; i < by_session.size(); ++i) {
+        if (by_session[i].empty()) {
+            continue;
+        }
+        WsSession& session = *sessions_[i];
+        bool sent = send_rpc(session, method, {{"channels", by_session[i]}},
+            [this, &session, batch, subscribe, method](const nlohmann::json& response) {
+                std::vector<std::string> accepted;
+                if (response.contains("result") && response["result"].is_array()) {
+                    for (const auto& channel : response["result"]) {
+                        if (channel.is_string()) {
+                            accepted.push_back(channel.get<std::string>());
+                        }
+                    }
+                    std::lock_guard<std::mutex> lock(subscription_mtx_);
+                    for (const auto& channel : accepted) {
+                        if (subscribe) {
+                            session.channels.insert(channel);
+                        } else {
+                            session.channels.erase(channel);
+                        }
+                    }
+                    Logger::getInstance().log(method + " accepted " + std::to_string(accepted.size()) +
+                                              " channel(s) on session " + std::to_string(session.index));
+                } else {
+                    Logger::getInstance().log(method + " failed: " + response.dump());
+                }
+                batch->complete(accepted);
+            });
+        if (!sent) {
+            Logger::getInstance().log("WebSocket not connected or send failed. Cannot " + method + " " +
+                                      std::to_string(by_session[i].size()) + " channel(s) on session " + std::to_string(i));
+            batch->complete({});
+        }
+    }
+
+    return future;
 }
 
 // Unsubscribe from all Deribit channels
 bool DeribitAPI::unsubscribe_all() {
     std::lock_guard<std::mutex> lock(subscription_mtx_);
-    if (subscribed_channels_.empty()) {
-        return true;
+
+    bool success = true;
+    for (auto& session : sessions_) {
+        if (session->channels.empty()) {
+            continue;
+        }
+
+        // Send the unsubscribe_all request
+        WsSession& target = *session;
+        bool sent = send_rpc(target, "public/unsubscribe_all", nlohmann::json::object(),
+            [this, &target](const nlohmann::json& response) {
+                if (response.contains("result")) {
+                    std::lock_guard<std::mutex> lock(subscription_mtx_);
+                    target.channels.clear();
+                } else {
+                    Logger::getInstance().log("public/unsubscribe_all failed: " + response.dump());
+                }
+            });
+        if (!sent) {
+            Logger::getInstance().log("WebSocket not connected or send failed. Cannot unsubscribe session " +
+                                      std::to_string(session->index) + " from channels.");
+            success = false;
+        }
     }
 
-    if (!ws_connected_) {
-        Logger::getInstance().log("WebSocket not connected. Cannot unsubscribe from channels.");
-        return false;
+    if (success) {
+        Logger::getInstance().log("Requested unsubscription from all Deribit channels.");
     }
+    return success;
+}
 
-    // Create JSON-RPC unsubscribe_all request
-    nlohmann::json unsubscribe_all_request = {
+void DeribitAPI::authenticate_ws(WsSession& session) {
+    if (api_key_.empty()) {
+        return;
+    }
+    nlohmann::json auth_params = {
+        {"client_id", api_key_},
+        {"client_secret", api_secret_},
+        {"grant_type", "client_credentials"}
+    };
+    bool sent = send_rpc(session, "public/auth", auth_params,
+        [this, &session](const nlohmann::json& response) {
+            on_ws_auth_response(session, response);
+        });
+    if (!sent) {
+        Logger::getInstance().log("public/auth could not be sent on session " + std::to_string(session.index));
+    }
+}
+
+void DeribitAPI::on_ws_auth_response(WsSession& session, const nlohmann::json& response) {
+    if (!response.contains("result") || !response["result"].contains("refresh_token")) {
+        Logger::getInstance().log("WebSocket authentication failed: " + response.dump());
+        return;
+    }
+    const auto& result = response["result"];
+    {
+        std::lock_guard<std::mutex> lock(session.mtx);
+        session.refresh_token = result["refresh_token"].get<std::string>();
+        session.auth_refresh_at = std::chrono::steady_clock::now() +
+                                  token_refresh_delay(result.value("expires_in", 900));
+    }
+    if (!session.authenticated.exchange(true)) {
+        Logger::getInstance().log("[session " + std::to_string(session.index) + "] WebSocket authenticated for order entry.");
+
+        // First auth on this connection: restore the private subscriptions
+        std::vector<std::string> channels;
+        {
+            std::lock_guard<std::mutex> lock(subscription_mtx_);
+            channels.assign(private_channels_.begin(), private_channels_.end());
+        }
+        if (!channels.empty()) {
+            send_private_subscribe(session, channels);
+        }
+    }
+}
+
+void DeribitAPI::subscribe_private(const std::vector<std::string>& channels) {
+    {
+        std::lock_guard<std::mutex> lock(subscription_mtx_);
+        for (const auto& channel : channels) {
+            InstrumentRegistry::getInstance().intern_channel(channel);
+            private_channels_.insert(channel);
+        }
+    }
+    // Not yet authenticated: on_ws_auth_response picks the channels up
+    WsSession& session = *sessions_[kOrderSession];
+    if (session.authenticated) {
+        send_private_subscribe(session, channels);
+    }
+}
+
+void DeribitAPI::send_private_subscribe(WsSession& session, const std::vector<std::string>& channels) {
+    size_t requested = channels.size();
+    bool sent = send_rpc(session, "private/subscribe", {{"channels", channels}},
+        [requested](const nlohmann::json& response) {
+            if (response.contains("result") && response["result"].is_array()) {
+                Logger::getInstance().log("private/subscribe accepted " + std::to_string(response["result"].size()) +
+                                          " of " + std::to_string(requested) + " channel(s).");
+            } else {
+                Logger::getInstance().log("private/subscribe failed: " + response.dump());
+            }
+        });
+    if (!sent) {
+        Logger::getInstance().log("private/subscribe could not be sent on session " + std::to_string(session.index));
+    }
+}
+
+bool DeribitAPI::is_ws_authenticated() const {
+    return sessions_[kOrderSession]->authenticated.load();
+}
+
+// Mass cancels; they share the cancel priority
+void DeribitAPI::submit_order(const std::string& method, const nlohmann::json& params, RpcCallback callback) {
+    uint64_t id = next_request_id_.fetch_add(1);
+    nlohmann::json request = {
         {"jsonrpc", "2.0"},
-        {"id", 1},
-        {"method", "public/unsubscribe_all"},
-        {"params", {}}
+        {"id", id},
+        {"method", method},
+        {"params", params}
     };
+    submit_encoded_order(id, request.dump(), RateLimiter::Priority::Cancel, std::move(callback));
+}
 
-    std::string message = unsubscribe_all_request.dump();
+// Matching engine request already encoded as a JSON-RPC message. With credit
+// available it is sent on the caller's thread; otherwise it waits on the
+// rate limiter's thread, or fails at once if it is shed.
+void DeribitAPI::submit_encoded_order(uint64_t id, std::string_view message, RateLimiter::Priority priority, RpcCallback callback) {
+    callback = watch_throttle(RateLimiter::Pool::MatchingEngine, std::move(callback));
+    if (rate_limiter_->try_acquire(RateLimiter::Pool::MatchingEngine, priority)) {
+        send_encoded_order(id, message, callback);
+        return;
+    }
+    rate_limiter_->submit(RateLimiter::Pool::MatchingEngine, priority,
+        [this, id, message = std::string(message), callback](bool admitted) {
+            if (!admitted) {
+                callback(shed_error());
+                return;
+            }
+            send_encoded_order(id, message, callback);
+        });
+}
 
-    // Send the unsubscribe_all message
-    websocketpp::lib::error_code ec;
-    ws_client_.send(ws_hdl_, message, websocketpp::frame::opcode::text, ec);
-    if (ec) {
-        Logger::getInstance().log("Failed to send unsubscribe_all message: " + ec.message());
-        return false;
+void DeribitAPI::send_encoded_order(uint64_t id, std::string_view message, RpcCallback callback) {
+    WsSession& session = *sessions_[kOrderSession];
+    if (session.authenticated && send_rpc_encoded(session, id, message, callback)) {
+        return;
     }
 
-    subscribed_channels_.clear();
-    Logger::getInstance().log("Unsubscribed from all Deribit channels.");
-    return true;
+    // WebSocket down or not yet authenticated: nothing was sent, so REST is safe
+    post_async(std::string(message), true, callback);
 }
 
-// Place Order
-nlohmann::json DeribitAPI::place_order(const std::string& instrument, const std::string& side, double quantity, double price) {
+// An exchange too_many_requests means our model ran ahead of the real limit;
+// drain the bucket so queued requests back off with it
+DeribitAPI::RpcCallback DeribitAPI::watch_throttle(RateLimiter::Pool pool, RpcCallback callback) {
+    return [this, pool, callback = std::move(callback)](const nlohmann::json& response) {
+        if (is_exchange_throttle(response)) {
+            rate_limiter_->on_throttled(pool);
+        }
+        callback(response);
+    };
+}
+
+// Tick size for the encoder's fast path; the first order on an unknown
+// instrument triggers a background public/get_instrument and uses the generic
+// format, as do orders within kTickSizeRetryInterval of a failed fetch
+double DeribitAPI::tick_size_for(const std::string& instrument) {
+    InstrumentRegistry& registry = InstrumentRegistry::getInstance();
+    InstrumentId id = registry.intern_instrument(instrument);
+    if (id == kInvalidId) {
+        return 0.0;
+    }
+    double tick_size = registry.tick_size(id);
+    if (tick_size > 0.0 || !registry.claim_tick_size_fetch(id)) {
+        return tick_size;
+    }
+
+    send_request_async("public/get_instrument", {{"instrument_name", instrument}}, false,
+        [id, instrument](const nlohmann::json& response) {
+            if (response.contains("result") && response["result"].contains("tick_size")) {
+                InstrumentRegistry::getInstance().set_tick_size(id, response["result"]["tick_size"].get<double>());
+            } else {
+                Logger::getInstance().log("Could not load tick size for " + instrument + ": " + response.dump());
+                InstrumentRegistry::getInstance().release_tick_size_fetch(id, kTickSizeRetryInterval);
+            }
+        });
+    return 0.0;
+}
+
+// Order requests are encoded without building nlohmann::json objects; the bytes
+// match what the params objects below used to dump to
+void DeribitAPI::place_order_async(const std::string& instrument, const std::string& side, double quantity, double price, RpcCallback callback) {
+    // {"instrument_name", "direction", "amount", "price"}
+    double tick_size = tick_size_for(instrument);
+    uint64_t id = next_request_id_.fetch_add(1);
+    submit_encoded_order(id, OrderEncoder::encode_buy(id, instrument, side, quantity, price, tick_size),
+                         RateLimiter::Priority::Normal, std::move(callback));
+}
+
+void DeribitAPI::cancel_order_async(const std::string& order_id, RpcCallback callback) {
+    // {"order_id"}
+    uint64_t id = next_request_id_.fetch_add(1);
+    submit_encoded_order(id, OrderEncoder::encode_cancel(id, order_id),
+                         RateLimiter::Priority::Cancel, std::move(callback));
+}
+
+void DeribitAPI::modify_order_async(const std::string& order_id, double new_quantity, double new_price, RpcCallback callback) {
+    // {"order_id", "amount", "price"}
+    uint64_t id = next_request_id_.fetch_add(1);
+    submit_encoded_order(id, OrderEncoder::encode_edit(id, order_id, new_quantity, new_price),
+                         RateLimiter::Priority::Normal, std::move(callback));
+}
+
+std::future<nlohmann::json> DeribitAPI::place_order_async(const std::string& instrument, const std::string& side, double quantity, double price) {
+    auto promise = std::make_shared<std::promise<nlohmann::json>>();
+    place_order_async(instrument, side, quantity, price, [promise](const nlohmann::json& response) {
+        promise->set_value(response);
+    });
+    return promise->get_future();
+}
+
+std::future<nlohmann::json> DeribitAPI::cancel_order_async(const std::string& order_id) {
+    auto promise = std::make_shared<std::promise<nlohmann::json>>();
+    cancel_order_async(order_id, [promise](const nlohmann::json& response) {
+        promise->set_value(response);
+    });
+    return promise->get_future();
+}
+
+std::future<nlohmann::json> DeribitAPI::modify_order_async(const std::string& order_id, double new_quantity, double new_price) {
+    auto promise = std::make_shared<std::promise<nlohmann::json>>();
+    modify_order_async(order_id, new_quantity, new_price, [promise](const nlohmann::json& response) {
+        promise->set_value(response);
+    });
+    return promise->get_future();
+}
+
+std::future<nlohmann::json> DeribitAPI::cancel_all_async() {
+    auto promise = std::make_shared<std::promise<nlohmann::json>>();
+    submit_order("private/cancel_all", nlohmann::json::object(), [promise](const nlohmann::json& response) {
+        promise->set_value(response);
+    });
+    return promise->get_future();
+}
+
+std::future<nlohmann::json> DeribitAPI::cancel_all_by_instrument_async(const std::string& instrument) {
     nlohmann::json params = {
-        {"instrument_name", instrument},
-        {"direction", side},
-        {"amount", quantity},
-        {"price", price}
+        {"instrument_name", instrument}
     };
-    return send_request("private/buy", params, true);
+    auto promise = std::make_shared<std::promise<nlohmann::json>>();
+    submit_order("private/cancel_all_by_instrument", params, [promise](const nlohmann::json& response) {
+        promise->set_value(response);
+    });
+    return promise->get_future();
+}
+
+nlohmann::json DeribitAPI::cancel_all() {
+    return cancel_all_async().get();
+}
+
+nlohmann::json DeribitAPI::cancel_all_by_instrument(const std::string& instrument) {
+    return cancel_all_by_instrument_async(instrument).get();
+}
+
+RpcAwaitable DeribitAPI::place_order_awaitable(const std::string& instrument, const std::string& side, double quantity, double price) {
+    auto state = std::make_shared<RpcAwaitable::State>();
+    place_order_async(instrument, side, quantity, price, [state](const nlohmann::json& response) {
+        state->complete(response);
+    });
+    return RpcAwaitable(state);
+}
+
+RpcAwaitable DeribitAPI::cancel_order_awaitable(const std::string& order_id) {
+    auto state = std::make_shared<RpcAwaitable::State>();
+    cancel_order_async(order_id, [state](const nlohmann::json& response) {
+        state->complete(response);
+    });
+    return RpcAwaitable(state);
+}
+
+RpcAwaitable DeribitAPI::modify_order_awaitable(const std::string& order_id, double new_quantity, double new_price) {
+    auto state = std::make_shared<RpcAwaitable::State>();
+    modify_order_async(order_id, new_quantity, new_price, [state](const nlohmann::json& response) {
+        state->complete(response);
+    });
+    return RpcAwaitable(state);
+}
+
+// Place Order
+nlohmann::json DeribitAPI::place_order(const std::string& instrument, const std::string& side, double quantity, double price) {
+    return place_order_async(instrument, side, quantity, price).get();
 }
 
 // Cancel Order
 nlohmann::json DeribitAPI::cancel_order(const std::string& order_id) {
-    nlohmann::json params = {
-        {"order_id", order_id}
-    };
-    return send_request("private/cancel", params, true);
+    return cancel_order_async(order_id).get();
 }
 
 // Modify Order
 nlohmann::json DeribitAPI::modify_order(const std::string& order_id, double new_quantity, double new_price) {
-    nlohmann::json params = {
-        {"order_id", order_id},
-        {"amount", new_quantity},
-        {"price", new_price}
-    };
-    return send_request("private/edit", params, true);
+    return modify_order_async(order_id, new_quantity, new_price).get();
 }
 
 // Get Order Book
-nlohmann::json DeribitAPI::get_orderbook(const std::string& instrument) {
+nlohmann::json DeribitAPI::get_orderbook(const std::string& instrument, int depth) {
     nlohmann::json params = {
         {"instrument_name", instrument}
     };
+    if (depth > 0) {
+        params["depth"] = depth;
+    }
     return send_request("public/get_order_book", params, false);
 }
 
@@ -360,6 +1039,11 @@ nlohmann::json DeribitAPI::get_positions() {
     return send_request("private/get_positions", params, true);
 }
 
+nlohmann::json DeribitAPI::get_open_orders() {
+    nlohmann::json params = {};
+    return send_request("private/get_open_orders", params, true);
+}
+
 // Implement the get_market_data method
 nlohmann::json DeribitAPI::get_market_data(const std::string& symbol) {
     nlohmann::json params = {
@@ -377,88 +1061,203 @@ nlohmann::json DeribitAPI::get_market_data(const std::string& symbol) {
 
 // Check if the current token is valid
 bool DeribitAPI::is_token_valid() {
-    std::lock_guard<std::mutex> lock(token_mtx_);
-    auto now = std::chrono::system_clock::now();
-    // Consider token valid if current time is before expiry minus a buffer (e.g., 60 seconds)
-    return !access_token_.empty() && (now + std::chrono::seconds(60) < token_expiry_);
+    std::shared_ptr<const TokenSnapshot> token = token_.load(std::memory_order_acquire);
+    return token && std::chrono::system_clock::now() < token->expiry;
 }
 
 // Authenticate and obtain access token
 bool DeribitAPI::authenticate() {
-    std::lock_guard<std::mutex> lock(token_mtx_);
-
-    // Prepare authentication request
     nlohmann::json auth_params = {
         {"client_id", api_key_},
         {"client_secret", api_secret_},
         {"grant_type", "client_credentials"}
     };
+    if (!request_token(auth_params)) {
+        return false;
+    }
+    Logger::getInstance().log("Authentication successful. Access token acquired.");
+    return true;
+}
 
-    nlohmann::json auth_response = send_request("public/auth", auth_params, false);
+// Run a public/auth grant over REST and publish the resulting token
+bool DeribitAPI::request_token(const nlohmann::json& auth_params) {
+    std::lock_guard<std::mutex> lock(auth_mtx_);
 
-    if (auth_response.contains("result")) {
-        access_token_ = auth_response["result"]["access_token"].get<std::string>();
-        int expires_in = auth_response["result"]["expires_in"].get<int>(); // in seconds
-        token_expiry_ = std::chrono::system_clock::now() + std::chrono::seconds(expires_in);
-        Logger::getInstance().log("Authentication successful. Access token acquired.");
-        return true;
-    } else {
+    nlohmann::json auth_response = send_request("public/auth", auth_params, false);
+    if (!auth_response.contains("result") || !auth_response["result"].contains("access_token")) {
         Logger::getInstance().log("Authentication failed: " + auth_response.dump());
         return false;
     }
+
+    const auto& result = auth_response["result"];
+    int expires_in = result["expires_in"].get<int>(); // in seconds
+    auto now = std::chrono::system_clock::now();
+    auto token = std::make_shared<TokenSnapshot>();
+    token->access_token = result["access_token"].get<std::string>();
+    token->refresh_token = result.value("refresh_token", std::string());
+    token->expiry = now + std::chrono::seconds(expires_in);
+    token->refresh_at = now + token_refresh_delay(expires_in);
+    token_.store(std::move(token), std::memory_order_release);
+    return true;
 }
 
-// Send API request
-nlohmann::json DeribitAPI::send_request(const std::string& method, const nlohmann::json& params, bool requires_auth) {
-    CURL* curl = curl_easy_init();
-    std::string readBuffer;
-    if(curl) {
-        nlohmann::json request_json;
-        request_json["jsonrpc"] = "2.0";
-        request_json["id"] = 1; // You can implement dynamic IDs if needed
-        request_json["method"] = method;
-        request_json["params"] = params;
-
-        std::string post_fields = request_json.dump();
-
-        curl_easy_setopt(curl, CURLOPT_URL, rest_url_.c_str());
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_fields.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
-
-        struct curl_slist *headers = NULL;
-        headers = curl_slist_append(headers, "Content-Type: application/json");
-
-        if (requires_auth) {
-            // Ensure token is valid
-            if (!is_token_valid()) {
-                if (!authenticate()) {
-                    Logger::getInstance().log("Failed to authenticate before making API request.");
-                    curl_easy_cleanup(curl);
-                    curl_slist_free_all(headers);
-                    return nlohmann::json();
-                }
+// Renews the REST token and the order session's WebSocket auth ahead of expiry
+void DeribitAPI::run_token_refresh() {
+    std::unique_lock<std::mutex> lock(token_refresh_mtx_);
+    while (running_) {
+        token_refresh_cv_.wait_for(lock, std::chrono::seconds(1));
+        if (!running_) {
+            break;
+        }
+        lock.unlock();
+
+        std::shared_ptr<const TokenSnapshot> token = token_.load(std::memory_order_acquire);
+        if (token && std::chrono::system_clock::now() >= token->refresh_at) {
+            bool refreshed = false;
+            if (!token->refresh_token.empty()) {
+                refreshed = request_token({
+                    {"grant_type", "refresh_token"},
+                    {"refresh_token", token->refresh_token}
+                });
+            }
+            // An expired or revoked refresh token needs a fresh login
+            if (!refreshed) {
+                refreshed = authenticate();
+            }
+            if (refreshed) {
+                Logger::getInstance().log("Access token refreshed in the background.");
+            } else {
+                // Retry shortly; the current token stays in use until it expires
+                auto retry = std::make_shared<TokenSnapshot>(*token);
+                retry->refresh_at = std::chrono::system_clock::now() + kTokenRetryInterval;
+                token_.compare_exchange_strong(token, std::move(retry));
             }
+        }
 
-            headers = curl_slist_append(headers, ("Authorization: Bearer " + access_token_).c_str());
+        WsSession& session = *sessions_[kOrderSession];
+        std::string ws_refresh_token;
+        {
+            std::lock_guard<std::mutex> session_lock(session.mtx);
+            if (session.connected && session.authenticated &&
+                std::chrono::steady_clock::now() >= session.auth_refresh_at) {
+                ws_refresh_token = session.refresh_token;
+                // Not due again until the response (or a retry) reschedules it
+                session.auth_refresh_at = std::chrono::steady_clock::now() + kTokenRetryInterval;
+            }
+        }
+        if (!ws_refresh_token.empty()) {
+            send_rpc(session, "public/auth", {{"grant_type", "refresh_token"}, {"refresh_token", ws_refresh_token}},
+                [this, &session](const nlohmann::json& response) {
+                    if (response.contains("result")) {
+                        on_ws_auth_response(session, response);
+                    } else {
+                        // Fall back to a new client_credentials login on the same connection
+                        Logger::getInstance().log("WebSocket token refresh failed: " + response.dump());
+                        authenticate_ws(session);
+                    }
+                });
         }
 
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        lock.lock();
+    }
+}
 
-        CURLcode res = curl_easy_perform(curl);
-        if(res != CURLE_OK) {
-            Logger::getInstance().log("CURL error: " + std::string(curl_easy_strerror(res)));
+// Send API request
+nlohmann::json DeribitAPI::send_request(const std::string& method, const nlohmann::json& params, bool requires_auth) {
+    nlohmann::json request_json;
+    request_json["jsonrpc"] = "2.0";
+    request_json["id"] = 1; // You can implement dynamic IDs if needed
+    request_json["method"] = method;
+    request_json["params"] = params;
+
+    std::string post_fields = request_json.dump();
+
+    // Blocking call, so wait here for rate limit credit
+    if (!rate_limiter_->try_acquire(RateLimiter::Pool::NonMatching, RateLimiter::Priority::Normal)) {
+        std::promise<bool> admitted;
+        rate_limiter_->submit(RateLimiter::Pool::NonMatching, RateLimiter::Priority::Normal,
+            [&admitted](bool ok) { admitted.set_value(ok); });
+        if (!admitted.get_future().get()) {
+            return shed_error();
         }
+    }
 
-        curl_easy_cleanup(curl);
-        curl_slist_free_all(headers);
+    std::string token;
+    if (requires_auth) {
+        // The refresher keeps the token current; never authenticate on the request path
+        std::shared_ptr<const TokenSnapshot> snapshot = token_.load(std::memory_order_acquire);
+        if (!snapshot || std::chrono::system_clock::now() >= snapshot->expiry) {
+            Logger::getInstance().log("No valid access token for " + method + "; call authenticate() first.");
+            return nlohmann::json();
+        }
+        token = snapshot->access_token;
     }
 
+    std::string readBuffer;
+    rest_pool_->post(post_fields, token, readBuffer);
+
     // Parse the response
     try {
-        return nlohmann::json::parse(readBuffer);
+        nlohmann::json response = nlohmann::json::parse(readBuffer);
+        if (is_exchange_throttle(response)) {
+            rate_limiter_->on_throttled(RateLimiter::Pool::NonMatching);
+        }
+        return response;
     } catch (const std::exception& e) {
         Logger::getInstance().log("JSON parse error: " + std::string(e.what()));
         return nlohmann::json();
     }
 }
+
+// Send API request without blocking; completes on the async REST thread
+void DeribitAPI::send_request_async(const std::string& method, const nlohmann::json& params, bool requires_auth, RpcCallback callback) {
+    nlohmann::json request_json;
+    request_json["jsonrpc"] = "2.0";
+    request_json["id"] = next_request_id_.fetch_add(1);
+    request_json["method"] = method;
+    request_json["params"] = params;
+
+    callback = watch_throttle(RateLimiter::Pool::NonMatching, std::move(callback));
+    rate_limiter_->submit(RateLimiter::Pool::NonMatching, RateLimiter::Priority::Normal,
+        [this, body = request_json.dump(), requires_auth, callback](bool admitted) {
+            if (!admitted) {
+                callback(shed_error());
+                return;
+            }
+            post_async(body, requires_auth, callback);
+        });
+}
+
+// body is a complete JSON-RPC request
+void DeribitAPI::post_async(std::string body, bool requires_auth, RpcCallback callback) {
+    std::string token;
+    if (requires_auth) {
+        std::shared_ptr<const TokenSnapshot> snapshot = token_.load(std::memory_order_acquire);
+        if (!snapshot || std::chrono::system_clock::now() >= snapshot->expiry) {
+            Logger::getInstance().log("No valid access token for REST request; call authenticate() first.");
+            callback({{"error", {{"message", "Not authenticated"}}}});
+            return;
+        }
+        token = snapshot->access_token;
+    }
+
+    async_rest_->post(std::move(body), token, [callback](CURLcode result, const std::string& response) {
+        if (result == CURLE_OPERATION_TIMEDOUT) {
+            // Same error as a WebSocket request past its deadline
+            callback({{"error", {{"message", "Request timed out"}}}});
+            return;
+        }
+        if (result != CURLE_OK) {
+            callback({{"error", {{"message", "HTTP request failed"}}}});
+            return;
+        }
+        nlohmann::json json_response;
+        try {
+            json_response = nlohmann::json::parse(response);
+        } catch (const std::exception& e) {
+            Logger::getInstance().log("JSON parse error: " + std::string(e.what()));
+            json_response = {{"error", {{"message", "Invalid JSON response"}}}};
+        }
+        callback(json_response);
+    });
+}
@@ -0,0 +1,170 @@
+// InstrumentRegistry.cpp
+
+#include "InstrumentRegistry.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <mutex>
+
+InstrumentRegistry::InstrumentRegistry()
+    : channels_(new ChannelEntry[kMaxChannels]), instruments_(new std::string[kMaxInstruments]),
+      tick_sizes_(new std::atomic<double>[kMaxInstruments]), tick_size_retry_at_(new std::atomic<int64_t>[kMaxInstruments]),
+      channel_count_(0), instrument_count_(0) {
+    for (size_t i = 0; i < kMaxInstruments; ++i) {
+        tick_sizes_[i].store(0.0, std::memory_order_relaxed);
+        tick_size_retry_at_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+InstrumentRegistry& InstrumentRegistry::getInstance() {
+    static InstrumentRegistry instance;
+    return instance;
+}
+
+ChannelType InstrumentRegistry::classify(std::string_view channel) {
+    std::string_view prefix = channel.substr(0, channel.find('.'));
+    if (prefix == "book") {
+        return std::count(channel.begin(), channel.end(), '.') == 2 ? ChannelType::Book : ChannelType::BookSnapshot;
+    }
+    if (prefix == "ticker") {
+        return ChannelType::Ticker;
+    }
+    if (prefix == "quote") {
+        return ChannelType::Quote;
+    }
+    if (prefix == "trades") {
+        return ChannelType::Trades;
+    }
+    if (prefix == "user") {
+        return ChannelType::User;
+    }
+    return ChannelType::Other;
+}
+
+// The instrument is the second dot-separated part of a channel name
+std::string_view InstrumentRegistry::channel_symbol(std::string_view channel) {
+    size_t first_dot = channel.find('.');
+    size_t second_dot = channel.find('.', first_dot + 1);
+    if (first_dot == std::string_view::npos || second_dot == std::string_view::npos) {
+        return "unknown";
+    }
+    return channel.substr(first_dot + 1, second_dot - first_dot - 1);
+}
+
+void InstrumentRegistry::set_instrument_listener(InstrumentListener listener) {
+    std::shared_ptr<const InstrumentListener> stored;
+    if (listener) {
+        stored = std::make_shared<const InstrumentListener>(std::move(listener));
+    }
+    instrument_listener_.store(std::move(stored), std::memory_order_release);
+}
+
+void InstrumentRegistry::notify_added(InstrumentId added) {
+    if (added == kInvalidId) {
+        return;
+    }
+    std::shared_ptr<const InstrumentListener> listener = instrument_listener_.load(std::memory_order_acquire);
+    if (listener) {
+        (*listener)(added);
+    }
+}
+
+ChannelId InstrumentRegistry::intern_channel(std::string_view channel) {
+    ChannelId existing = find_channel(channel);
+    if (existing != kInvalidId) {
+        return existing;
+    }
+
+    InstrumentId added = kInvalidId;
+    ChannelId id;
+    {
+        std::unique_lock<std::shared_mutex> lock(mtx_);
+        id = intern_channel_locked(channel, added);
+    }
+    notify_added(added);
+    return id;
+}
+
+ChannelId InstrumentRegistry::intern_channel_locked(std::string_view channel, InstrumentId& added) {
+    auto it = channel_ids_.find(channel);
+    if (it != channel_ids_.end()) {
+        return it->second;
+    }
+
+    size_t id = channel_count_.load(std::memory_order_relaxed);
+    if (id >= kMaxChannels) {
+        Logger::getInstance().log("Instrument registry full, cannot intern channel: " + std::string(channel));
+        return kInvalidId;
+    }
+
+    ChannelEntry& entry = channels_[id];
+    entry.name = std::string(channel);
+    entry.instrument = intern_instrument_locked(channel_symbol(channel), added);
+    entry.type = classify(channel);
+    channel_ids_.emplace(entry.name, static_cast<ChannelId>(id));
+    channel_count_.store(id + 1, std::memory_order_release);
+    return static_cast<ChannelId>(id);
+}
+
+InstrumentId InstrumentRegistry::intern_instrument(std::string_view instrument) {
+    InstrumentId existing = find_instrument(instrument);
+    if (existing != kInvalidId) {
+        return existing;
+    }
+
+    InstrumentId added = kInvalidId;
+    InstrumentId id;
+    {
+        std::unique_lock<std::shared_mutex> lock(mtx_);
+        id = intern_instrument_locked(instrument, added);
+    }
+    notify_added(added);
+    return id;
+}
+
+InstrumentId InstrumentRegistry::intern_instrument_locked(std::string_view instrument, InstrumentId& added) {
+    auto it = instrument_ids_.find(instrument);
+    if (it != instrument_ids_.end()) {
+        return it->second;
+    }
+
+    size_t id = instrument_count_.load(std::memory_order_relaxed);
+    if (id >= kMaxInstruments) {
+        Logger::getInstance().log("Instrument registry full, cannot intern instrument: " + std::string(instrument));
+        return kInvalidId;
+    }
+
+    instruments_[id] = std::string(instrument);
+    instrument_ids_.emplace(instruments_[id], static_cast<InstrumentId>(id));
+    instrument_count_.store(id + 1, std::memory_order_release);
+    added = static_cast<InstrumentId>(id);
+    return static_cast<InstrumentId>(id);
+}
+
+ChannelId InstrumentRegistry::find_channel(std::string_view channel) const {
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    auto it = channel_ids_.find(channel);
+    return it != channel_ids_.end() ? it->second : kInvalidId;
+}
+
+InstrumentId InstrumentRegistry::find_instrument(std::string_view instrument) const {
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    auto it = instrument_ids_.find(instrument);
+    return it != instrument_ids_.end() ? it->second : kInvalidId;
+}
+
+static int64_t steady_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool InstrumentRegistry::claim_tick_size_fetch(InstrumentId id) {
+    int64_t retry_at = tick_size_retry_at_[id].load(std::memory_order_acquire);
+    if (retry_at == kTickSizeFetching || (retry_at != 0 && steady_now_ns() < retry_at)) {
+        return false;
+    }
+    return tick_size_retry_at_[id].compare_exchange_strong(retry_at, kTickSizeFetching, std::memory_order_acq_rel);
+}
+
+void InstrumentRegistry::release_tick_size_fetch(InstrumentId id, std::chrono::steady_clock::duration retry_after) {
+    int64_t delay = std::chrono::duration_cast<std::chrono::nanoseconds>(retry_after).count();
+    tick_size_retry_at_[id].store(steady_now_ns() + std::max<int64_t>(delay, 1), std::memory_order_release);
+}
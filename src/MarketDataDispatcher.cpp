@@ -0,0 +1,253 @@
+// MarketDataDispatcher.cpp
+
+#include "MarketDataDispatcher.hpp"
+#include "SubscriptionParser.hpp"
+#include "Logger.hpp"
+
+// Upper bound on frames processed before conflated slots are flushed, so a
+// consumer that never fully catches up still delivers state updates
+static const size_t kMaxConflationBatch = 1024;
+
+// Per-worker ring size; a full worker stalls the consumer, not the sockets
+static const size_t kWorkerQueueCapacity = 8192;
+
+MarketDataDispatcher::MarketDataDispatcher(size_t queue_count, size_t queue_capacity, FrameHandler frame_handler,
+                                           bool conflation_enabled, size_t worker_count)
+    : responses_pending_(false), frame_handler_(frame_handler), user_callbacks_(std::make_shared<const UserCallbacks>()),
+      conflation_enabled_(conflation_enabled), frames_since_flush_(0),
+      running_(false), wake_seq_(0), enqueued_(0), dropped_(0), conflated_(0) {
+    for (size_t i = 0; i < queue_count; ++i) {
+        queues_.push_back(std::make_unique<SpscQueue<std::string>>(queue_capacity));
+    }
+    if (worker_count > 0) {
+        workers_ = std::make_unique<MarketDataWorkerPool>(worker_count, kWorkerQueueCapacity);
+    }
+}
+
+MarketDataDispatcher::~MarketDataDispatcher() {
+    stop();
+}
+
+void MarketDataDispatcher::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    if (workers_) {
+        workers_->start();
+    }
+    consumer_thread_ = std::thread(&MarketDataDispatcher::run, this);
+}
+
+void MarketDataDispatcher::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    wake_seq_.fetch_add(1, std::memory_order_release);
+    wake_seq_.notify_all();
+    if (consumer_thread_.joinable()) {
+        consumer_thread_.join();
+    }
+    // After the consumer, which is the pool's only producer
+    if (workers_) {
+        workers_->stop();
+    }
+}
+
+void MarketDataDispatcher::set_message_callback(MessageCallback callback) {
+    if (workers_) {
+        workers_->set_message_callback(callback);
+    }
+    message_callback_ = callback;
+}
+
+void MarketDataDispatcher::add_user_callback(MessageCallback callback) {
+    std::lock_guard<std::mutex> lock(user_callbacks_mtx_);
+    auto callbacks = std::make_shared<UserCallbacks>(*user_callbacks_.load(std::memory_order_acquire));
+    callbacks->push_back(std::move(callback));
+    user_callbacks_.store(std::move(callbacks), std::memory_order_release);
+}
+
+// True if the notification was a user channel taken by the user callbacks
+bool MarketDataDispatcher::dispatch_user(ChannelId channel, std::string_view data) {
+    if (InstrumentRegistry::getInstance().channel_type(channel) != ChannelType::User) {
+        return false;
+    }
+    std::shared_ptr<const UserCallbacks> callbacks = user_callbacks_.load(std::memory_order_acquire);
+    if (callbacks->empty()) {
+        return false;
+    }
+    for (const auto& callback : *callbacks) {
+        callback(channel, data);
+    }
+    return true;
+}
+
+bool MarketDataDispatcher::enqueue(size_t queue, std::string&& frame) {
+    if (!queues_[queue]->try_push(std::move(frame))) {
+        uint64_t dropped = dropped_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (dropped == 1 || dropped % 10000 == 0) {
+            Logger::getInstance().log("Market data queue full, dropped frames: " + std::to_string(dropped));
+        }
+        return false;
+    }
+    enqueued_.fetch_add(1, std::memory_order_relaxed);
+
+    // notify_one only enters the kernel when the consumer is actually parked
+    wake_seq_.fetch_add(1, std::memory_order_release);
+    wake_seq_.notify_one();
+    return true;
+}
+
+void MarketDataDispatcher::enqueue_response(std::string&& frame) {
+    {
+        std::lock_guard<std::mutex> lock(responses_mtx_);
+        responses_.push_back(std::move(frame));
+    }
+    responses_pending_.store(true, std::memory_order_release);
+
+    wake_seq_.fetch_add(1, std::memory_order_release);
+    wake_seq_.notify_one();
+}
+
+// Hand every queued response to the frame handler; the lock is only held for the swap
+void MarketDataDispatcher::process_responses() {
+    if (!responses_pending_.load(std::memory_order_acquire)) {
+        return;
+    }
+    responses_pending_.store(false, std::memory_order_relaxed);
+    std::deque<std::string> responses;
+    {
+        std::lock_guard<std::mutex> lock(responses_mtx_);
+        responses.swap(responses_);
+    }
+    for (auto& response : responses) {
+        try {
+            if (frame_handler_) {
+                frame_handler_(response);
+            }
+        } catch (const std::exception& e) {
+            Logger::getInstance().log("Response dispatch error: " + std::string(e.what()));
+        }
+    }
+}
+
+MarketDataDispatcher::Stats MarketDataDispatcher::get_stats() const {
+    size_t depth = 0;
+    size_t capacity = 0;
+    for (const auto& queue : queues_) {
+        depth += queue->size();
+        capacity += queue->capacity();
+    }
+    return Stats{
+        depth,
+        capacity,
+        enqueued_.load(std::memory_order_relaxed),
+        dropped_.load(std::memory_order_relaxed),
+        conflated_.load(std::memory_order_relaxed),
+        workers_ ? workers_->backlog() : 0
+    };
+}
+
+void MarketDataDispatcher::run() {
+    std::string frame;
+    while (running_.load(std::memory_order_acquire)) {
+        // Read the sequence before checking the rings so a push in between wakes us
+        uint32_t seen = wake_seq_.load(std::memory_order_acquire);
+
+        // Responses first: a caller is blocked on each of them
+        process_responses();
+
+        // One frame per ring per pass keeps a busy session from starving the others
+        bool popped = false;
+        for (auto& queue : queues_) {
+            if (!queue->try_pop(frame)) {
+                continue;
+            }
+            popped = true;
+
+            try {
+                process(frame);
+            } catch (const std::exception& e) {
+                Logger::getInstance().log("Market data dispatch error: " + std::string(e.what()));
+            }
+
+            if (++frames_since_flush_ >= kMaxConflationBatch) {
+                flush_conflated();
+            }
+        }
+
+        if (!popped) {
+            // Backlog cleared: deliver the latest state collected during the burst
+            flush_conflated();
+            wake_seq_.wait(seen, std::memory_order_acquire);
+        }
+    }
+}
+
+void MarketDataDispatcher::flush_conflated() {
+    frames_since_flush_ = 0;
+    if (conflation_.empty()) {
+        return;
+    }
+    try {
+        conflation_.drain([this](ChannelId channel, std::string_view data) {
+            dispatch(channel, data);
+        });
+    } catch (const std::exception& e) {
+        Logger::getInstance().log("Market data dispatch error: " + std::string(e.what()));
+    }
+    conflated_.store(conflation_.conflated_count(), std::memory_order_relaxed);
+}
+
+void MarketDataDispatcher::process(std::string& frame) {
+    SubscriptionView view;
+    if (SubscriptionParser::parse(frame, view)) {
+        // Channels are interned on subscribe; this is the only string lookup on the hot path
+        InstrumentRegistry& registry = InstrumentRegistry::getInstance();
+        ChannelId channel = registry.find_channel(view.channel);
+        if (channel == kInvalidId) {
+            channel = registry.intern_channel(view.channel);
+            if (channel == kInvalidId) {
+                return;
+            }
+        }
+
+        if (conflation_enabled_ && is_snapshot_channel(registry.channel_type(channel))) {
+            conflation_.update(channel, view.data);
+        } else {
+            dispatch(channel, std::move(frame), view.data);
+        }
+        return;
+    }
+
+    if (frame_handler_) {
+        frame_handler_(frame);
+    }
+}
+
+void MarketDataDispatcher::dispatch(ChannelId channel, std::string_view data) {
+    if (dispatch_user(channel, data)) {
+        return;
+    }
+    if (workers_) {
+        workers_->submit(channel, std::string(data), 0, data.size());
+        return;
+    }
+    if (message_callback_) {
+        message_callback_(channel, data);
+    }
+}
+
+void MarketDataDispatcher::dispatch(ChannelId channel, std::string&& frame, std::string_view data) {
+    if (dispatch_user(channel, data)) {
+        return;
+    }
+    if (workers_) {
+        size_t offset = data.data() - frame.data();
+        workers_->submit(channel, std::move(frame), offset, data.size());
+        return;
+    }
+    if (message_callback_) {
+        message_callback_(channel, data);
+    }
+}
@@ -0,0 +1,99 @@
+// MarketDataWorkerPool.cpp
+
+#include "MarketDataWorkerPool.hpp"
+#include "Logger.hpp"
+
+MarketDataWorkerPool::MarketDataWorkerPool(size_t worker_count, size_t queue_capacity)
+    : running_(false) {
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>(queue_capacity));
+    }
+}
+
+MarketDataWorkerPool::~MarketDataWorkerPool() {
+    stop();
+}
+
+void MarketDataWorkerPool::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    for (auto& worker : workers_) {
+        worker->thread = std::thread(&MarketDataWorkerPool::run, this, std::ref(*worker));
+    }
+}
+
+void MarketDataWorkerPool::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    for (auto& worker : workers_) {
+        worker->wake_seq.fetch_add(1, std::memory_order_release);
+        worker->wake_seq.notify_all();
+    }
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+void MarketDataWorkerPool::set_message_callback(MessageCallback callback) {
+    message_callback_ = callback;
+}
+
+size_t MarketDataWorkerPool::worker_for(ChannelId channel) const {
+    // Book, trades and ticker channels of one instrument share a worker; ids are dense,
+    // so the modulo spreads them evenly
+    InstrumentId instrument = InstrumentRegistry::getInstance().channel_instrument(channel);
+    uint32_t key = instrument != kInvalidId ? instrument : channel;
+    return key % workers_.size();
+}
+
+void MarketDataWorkerPool::submit(ChannelId channel, std::string&& buffer, size_t offset, size_t length) {
+    Worker& worker = *workers_[worker_for(channel)];
+
+    WorkItem item;
+    item.channel = channel;
+    item.offset = offset;
+    item.length = length;
+    item.buffer = std::move(buffer);
+
+    // Back-pressure the dispatcher instead of dropping: a lost book update would
+    // force a REST resync. The receive rings absorb the burst and count any drops.
+    while (!worker.queue.try_push(std::move(item))) {
+        if (!running_.load(std::memory_order_acquire)) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+    worker.wake_seq.fetch_add(1, std::memory_order_release);
+    worker.wake_seq.notify_one();
+}
+
+size_t MarketDataWorkerPool::backlog() const {
+    size_t depth = 0;
+    for (const auto& worker : workers_) {
+        depth += worker->queue.size();
+    }
+    return depth;
+}
+
+void MarketDataWorkerPool::run(Worker& worker) {
+    WorkItem item;
+    while (running_.load(std::memory_order_acquire)) {
+        uint32_t seen = worker.wake_seq.load(std::memory_order_acquire);
+        if (!worker.queue.try_pop(item)) {
+            worker.wake_seq.wait(seen, std::memory_order_acquire);
+            continue;
+        }
+
+        try {
+            if (message_callback_) {
+                message_callback_(item.channel, std::string_view(item.buffer).substr(item.offset, item.length));
+            }
+        } catch (const std::exception& e) {
+            Logger::getInstance().log("Market data worker error: " + std::string(e.what()));
+        }
+    }
+}
@@ -0,0 +1,81 @@
+// OrderBook.cpp
+
+#include "OrderBook.hpp"
+#include <algorithm>
+
+void OrderBook::clear() {
+    bids_.clear();
+    asks_.clear();
+    change_id_ = 0;
+}
+
+void OrderBook::apply(Side side, std::string_view action, double price, double amount) {
+    if (action == "delete" || amount == 0.0) {
+        remove_level(side, price);
+    } else {
+        // "new" and "change" both carry the absolute amount at the price
+        set_level(side, price, amount);
+    }
+}
+
+void OrderBook::set_level(Side side, double price, double amount) {
+    auto& book_side = levels(side);
+    // Bids ascend and asks descend so that the best price is always last
+    auto it = side == Side::Bid
+        ? std::lower_bound(book_side.begin(), book_side.end(), price,
+                           [](const PriceLevel& l, double p) { return l.price < p; })
+        : std::lower_bound(book_side.begin(), book_side.end(), price,
+                           [](const PriceLevel& l, double p) { return l.price > p; });
+
+    if (it != book_side.end() && it->price == price) {
+        it->amount = amount;
+    } else {
+        book_side.insert(it, PriceLevel{price, amount});
+    }
+}
+
+void OrderBook::remove_level(Side side, double price) {
+    auto& book_side = levels(side);
+    auto it = side == Side::Bid
+        ? std::lower_bound(book_side.begin(), book_side.end(), price,
+                           [](const PriceLevel& l, double p) { return l.price < p; })
+        : std::lower_bound(book_side.begin(), book_side.end(), price,
+                           [](const PriceLevel& l, double p) { return l.price > p; });
+
+    if (it != book_side.end() && it->price == price) {
+        book_side.erase(it);
+    }
+}
+
+bool OrderBook::best_bid(PriceLevel& level) const {
+    if (bids_.empty()) {
+        return false;
+    }
+    level = bids_.back();
+    return true;
+}
+
+bool OrderBook::best_ask(PriceLevel& level) const {
+    if (asks_.empty()) {
+        return false;
+    }
+    level = asks_.back();
+    return true;
+}
+
+void OrderBook::top_bids(size_t depth, std::vector<PriceLevel>& out) const {
+    top(bids_, depth, out);
+}
+
+void OrderBook::top_asks(size_t depth, std::vector<PriceLevel>& out) const {
+    top(asks_, depth, out);
+}
+
+void OrderBook::top(const std::vector<PriceLevel>& levels, size_t depth, std::vector<PriceLevel>& out) {
+    out.clear();
+    size_t count = std::min(depth, levels.size());
+    out.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        out.push_back(levels[levels.size() - 1 - i]);
+    }
+}
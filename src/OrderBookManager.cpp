@@ -0,0 +1,258 @@
+// OrderBookManager.cpp
+
+#include "OrderBookManager.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <iterator>
+
+// Depth requested from public/get_order_book when rebuilding after a gap
+static const int kResyncDepth = 1000;
+
+// Backoff between failed rebuilds, doubling per consecutive failure
+static const std::chrono::milliseconds kResyncBackoffMin(250);
+static const std::chrono::milliseconds kResyncBackoffMax(30000);
+
+// Updates kept while waiting for a snapshot; past this the buffer is restarted
+static const size_t kMaxBufferedUpdates = 10000;
+
+OrderBookManager::OrderBookManager(DeribitAPI& api)
+    : api_(api), books_(new std::atomic<InstrumentBook*>[InstrumentRegistry::kMaxInstruments]) {
+    for (size_t i = 0; i < InstrumentRegistry::kMaxInstruments; ++i) {
+        books_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+OrderBookManager::InstrumentBook* OrderBookManager::find_book(const std::string& instrument) {
+    InstrumentId id = InstrumentRegistry::getInstance().find_instrument(instrument);
+    if (id == kInvalidId) {
+        return nullptr;
+    }
+    return books_[id].load(std::memory_order_acquire);
+}
+
+OrderBookManager::InstrumentBook& OrderBookManager::get_or_create_book(InstrumentId instrument) {
+    InstrumentBook* entry = books_[instrument].load(std::memory_order_acquire);
+    if (entry) {
+        return *entry;
+    }
+
+    std::lock_guard<std::mutex> lock(books_mtx_);
+    entry = books_[instrument].load(std::memory_order_relaxed);
+    if (!entry) {
+        owned_books_.push_back(std::make_unique<InstrumentBook>());
+        entry = owned_books_.back().get();
+        books_[instrument].store(entry, std::memory_order_release);
+    }
+    return *entry;
+}
+
+bool OrderBookManager::on_book_update(ChannelId channel, std::string_view data) {
+    // Grouped snapshot channels (book.<instrument>.<group>.<depth>.<interval>) are not tracked
+    const InstrumentRegistry& registry = InstrumentRegistry::getInstance();
+    if (registry.channel_type(channel) != ChannelType::Book) {
+        return false;
+    }
+    InstrumentId instrument_id = registry.channel_instrument(channel);
+    if (instrument_id == kInvalidId) {
+        return false;
+    }
+    const std::string& instrument = registry.instrument_name(instrument_id);
+
+    // Reused across updates so steady-state decoding does not allocate
+    thread_local BookUpdate update;
+    if (!BookDecoder::decode_book(data, update) && !BookDecoder::decode_book_generic(data, update)) {
+        Logger::getInstance().log("Order book update parse error on " + registry.channel_name(channel));
+        return true;
+    }
+
+    InstrumentBook& entry = get_or_create_book(instrument_id);
+    bool request = false;
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(entry.mtx);
+        if (update.is_snapshot) {
+            entry.book.clear();
+            entry.synced = true;
+            entry.bridging = false;
+            // A REST snapshot still in flight is now stale
+            entry.resyncing = false;
+            ++entry.resync_generation;
+            entry.buffered.clear();
+            apply_levels(entry.book, OrderBook::Side::Bid, update.bids);
+            apply_levels(entry.book, OrderBook::Side::Ask, update.asks);
+            entry.book.set_change_id(update.change_id);
+            return true;
+        }
+
+        if (entry.synced && apply_update(instrument, entry, update)) {
+            return true;
+        }
+
+        // No usable base: keep the update for the replay and rebuild from REST
+        entry.synced = false;
+        entry.bridging = false;
+        if (entry.buffered.size() >= kMaxBufferedUpdates) {
+            // Too far behind to bridge; the replay will find the gap and start over
+            entry.buffered.clear();
+        }
+        entry.buffered.push_back(update);
+        request = begin_resync(entry, generation);
+    }
+
+    // Outside the lock: the callback may run before send_request_async returns
+    if (request) {
+        request_snapshot(instrument_id, generation);
+    }
+    return true;
+}
+
+// Chains an incremental update onto a synced book; false on a gap
+bool OrderBookManager::apply_update(const std::string& instrument, InstrumentBook& entry, const BookUpdate& update) {
+    if (entry.bridging) {
+        if (update.change_id <= entry.book.change_id()) {
+            // Already contained in the REST snapshot
+            return true;
+        }
+        if (update.prev_change_id > entry.book.change_id()) {
+            Logger::getInstance().log("Order book gap after resync for " + instrument + ", resyncing again.");
+            return false;
+        }
+        // Levels carry absolute amounts, so an update overlapping the snapshot is safe to apply
+        entry.bridging = false;
+    } else if (update.prev_change_id != entry.book.change_id()) {
+        Logger::getInstance().log("Order book gap for " + instrument +
+                                  ": expected prev_change_id " + std::to_string(entry.book.change_id()) +
+                                  ", got " + std::to_string(update.prev_change_id) + ". Resyncing.");
+        return false;
+    }
+
+    apply_levels(entry.book, OrderBook::Side::Bid, update.bids);
+    apply_levels(entry.book, OrderBook::Side::Ask, update.asks);
+    entry.book.set_change_id(update.change_id);
+    return true;
+}
+
+void OrderBookManager::apply_levels(OrderBook& book, OrderBook::Side side, const LevelBuffer& levels) {
+    for (size_t i = 0; i < levels.size(); ++i) {
+        if (levels.actions[i] == LevelBuffer::Delete || levels.amounts[i] == 0.0) {
+            book.remove_level(side, levels.prices[i]);
+        } else {
+            // "new" and "change" both carry the absolute amount at the price
+            book.set_level(side, levels.prices[i], levels.amounts[i]);
+        }
+    }
+}
+
+// Claims the next snapshot request unless one is in flight or a failure is backing off
+bool OrderBookManager::begin_resync(InstrumentBook& entry, uint64_t& generation) {
+    if (entry.resyncing || std::chrono::steady_clock::now() < entry.next_resync) {
+        return false;
+    }
+    entry.resyncing = true;
+    generation = ++entry.resync_generation;
+    return true;
+}
+
+// Exponential backoff before the next snapshot request; returns the delay in ms
+int64_t OrderBookManager::back_off(InstrumentBook& entry) {
+    int shift = std::min(entry.resync_failures, 10);
+    ++entry.resync_failures;
+    auto delay = std::min(kResyncBackoffMin * (int64_t(1) << shift), kResyncBackoffMax);
+    entry.next_resync = std::chrono::steady_clock::now() + delay;
+    return delay.count();
+}
+
+void OrderBookManager::request_snapshot(InstrumentId instrument, uint64_t generation) {
+    nlohmann::json params = {
+        {"instrument_name", InstrumentRegistry::getInstance().instrument_name(instrument)},
+        {"depth", kResyncDepth}
+    };
+    api_.send_request_async("public/get_order_book", params, false,
+        [this, instrument, generation](const nlohmann::json& response) {
+            on_snapshot(instrument, generation, response);
+        });
+}
+
+// Runs on the async REST thread
+void OrderBookManager::on_snapshot(InstrumentId instrument_id, uint64_t generation, const nlohmann::json& response) {
+    const std::string& instrument = InstrumentRegistry::getInstance().instrument_name(instrument_id);
+    InstrumentBook& entry = get_or_create_book(instrument_id);
+    std::lock_guard<std::mutex> lock(entry.mtx);
+    if (generation != entry.resync_generation) {
+        // A snapshot from the channel itself arrived first
+        return;
+    }
+    entry.resyncing = false;
+
+    if (!response.contains("result") || !response["result"].is_object()) {
+        int64_t delay_ms = back_off(entry);
+        Logger::getInstance().log("Order book resync failed for " + instrument + ": " + response.dump() +
+                                  ". Retrying in " + std::to_string(delay_ms) + " ms.");
+        return;
+    }
+
+    const auto& result = response["result"];
+    entry.book.clear();
+    for (const auto& side : {std::make_pair("bids", OrderBook::Side::Bid), std::make_pair("asks", OrderBook::Side::Ask)}) {
+        auto it = result.find(side.first);
+        if (it == result.end() || !it->is_array()) {
+            continue;
+        }
+        for (const auto& level : *it) {
+            // REST levels are [price, amount]
+            if (level.size() < 2) {
+                continue;
+            }
+            entry.book.set_level(side.second, level[0].get<double>(), level[1].get<double>());
+        }
+    }
+    entry.book.set_change_id(result.value("change_id", uint64_t(0)));
+    entry.synced = true;
+    entry.bridging = true;
+    Logger::getInstance().log("Order book resynced from REST for " + instrument +
+                              " at change_id " + std::to_string(entry.book.change_id()) + ", replaying " +
+                              std::to_string(entry.buffered.size()) + " buffered update(s).");
+
+    // Replay what arrived while the request was out; the chain must bridge onto the snapshot
+    std::vector<BookUpdate> buffered;
+    buffered.swap(entry.buffered);
+    for (size_t i = 0; i < buffered.size(); ++i) {
+        if (!apply_update(instrument, entry, buffered[i])) {
+            // The snapshot is older than the buffered chain; keep the rest and try again later
+            entry.synced = false;
+            entry.bridging = false;
+            entry.buffered.assign(std::make_move_iterator(buffered.begin() + i), std::make_move_iterator(buffered.end()));
+            back_off(entry);
+            return;
+        }
+    }
+    entry.resync_failures = 0;
+}
+
+bool OrderBookManager::get_best_bid_ask(const std::string& instrument, PriceLevel& bid, PriceLevel& ask, bool& has_bid, bool& has_ask) {
+    InstrumentBook* entry = find_book(instrument);
+    if (!entry) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(entry->mtx);
+    if (!entry->synced) {
+        return false;
+    }
+    has_bid = entry->book.best_bid(bid);
+    has_ask = entry->book.best_ask(ask);
+    return true;
+}
+
+bool OrderBookManager::get_depth(const std::string& instrument, size_t depth, std::vector<PriceLevel>& bids, std::vector<PriceLevel>& asks) {
+    InstrumentBook* entry = find_book(instrument);
+    if (!entry) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(entry->mtx);
+    if (!entry->synced) {
+        return false;
+    }
+    entry->book.top_bids(depth, bids);
+    entry->book.top_asks(depth, asks);
+    return true;
+}
@@ -0,0 +1,166 @@
+// OrderEncoder.cpp
+
+#include "OrderEncoder.hpp"
+#include <cmath>
+#include <nlohmann/json.hpp>
+
+// Up to 15 significant digits a decimal maps to a unique double, so an exact
+// on-tick decimal is also the shortest representation
+static const int64_t kMaxTickMantissa = 1000000000000000LL;
+static const int kMaxTickDecimals = 9;
+// nlohmann switches to exponent notation below this magnitude
+static const double kMinFixedMagnitude = 1e-4;
+
+static const double kPow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+std::string& OrderEncoder::begin_request(uint64_t id, std::string_view method) {
+    thread_local std::string buffer;
+    buffer.clear();
+    if (buffer.capacity() < 256) {
+        buffer.reserve(256);
+    }
+    buffer.append("{\"id\":");
+    append_uint(buffer, id);
+    buffer.append(",\"jsonrpc\":\"2.0\",\"method\":");
+    append_string(buffer, method);
+    buffer.append(",\"params\":{");
+    return buffer;
+}
+
+std::string_view OrderEncoder::encode_buy(uint64_t id, std::string_view instrument, std::string_view direction,
+                                          double amount, double price, double tick_size) {
+    std::string& out = begin_request(id, "private/buy");
+    out.append("\"amount\":");
+    append_double(out, amount);
+    out.append(",\"direction\":");
+    append_string(out, direction);
+    out.append(",\"instrument_name\":");
+    append_string(out, instrument);
+    out.append(",\"price\":");
+    append_double(out, price, tick_size);
+    out.append("}}");
+    return out;
+}
+
+std::string_view OrderEncoder::encode_edit(uint64_t id, std::string_view order_id, double amount, double price) {
+    std::string& out = begin_request(id, "private/edit");
+    out.append("\"amount\":");
+    append_double(out, amount);
+    out.append(",\"order_id\":");
+    append_string(out, order_id);
+    out.append(",\"price\":");
+    append_double(out, price);
+    out.append("}}");
+    return out;
+}
+
+std::string_view OrderEncoder::encode_cancel(uint64_t id, std::string_view order_id) {
+    std::string& out = begin_request(id, "private/cancel");
+    out.append("\"order_id\":");
+    append_string(out, order_id);
+    out.append("}}");
+    return out;
+}
+
+void OrderEncoder::append_uint(std::string& out, uint64_t value) {
+    char digits[20];
+    size_t len = 0;
+    do {
+        digits[len++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (len) {
+        out.push_back(digits[--len]);
+    }
+}
+
+void OrderEncoder::append_string(std::string& out, std::string_view value) {
+    for (char c : value) {
+        unsigned char uc = static_cast<unsigned char>(c);
+        if (uc < 0x20 || uc >= 0x80 || c == '"' || c == '\\') {
+            // Rare: let nlohmann apply its escaping and UTF-8 rules
+            out.append(nlohmann::json(std::string(value)).dump());
+            return;
+        }
+    }
+    out.push_back('"');
+    out.append(value);
+    out.push_back('"');
+}
+
+void OrderEncoder::append_double(std::string& out, double value, double tick_size) {
+    if (!std::isfinite(value)) {
+        out.append("null");
+        return;
+    }
+    if (append_on_tick(out, value, tick_size)) {
+        return;
+    }
+    append_shortest(out, value);
+}
+
+// nlohmann's own Grisu2 formatter, which dump() uses, written straight into the
+// buffer: the digits and layout are byte for byte what the generic path sent
+void OrderEncoder::append_shortest(std::string& out, double value) {
+    char number[64];
+    char* end = nlohmann::detail::to_chars(number, number + sizeof(number), value);
+    out.append(number, static_cast<size_t>(end - number));
+}
+
+// Integer arithmetic for prices that sit exactly on the instrument's tick grid
+bool OrderEncoder::append_on_tick(std::string& out, double value, double tick_size) {
+    if (tick_size <= 0.0 || value == 0.0 || std::fabs(value) < kMinFixedMagnitude) {
+        return false;
+    }
+
+    // Decimal places of the tick (0.5 -> 1, 0.0005 -> 4)
+    int decimals = 0;
+    while (decimals <= kMaxTickDecimals) {
+        double scaled = tick_size * kPow10[decimals];
+        if (std::fabs(scaled - std::round(scaled)) < 1e-9 * scaled) {
+            break;
+        }
+        ++decimals;
+    }
+    if (decimals > kMaxTickDecimals) {
+        return false;
+    }
+
+    double scale = kPow10[decimals];
+    double scaled_value = value * scale;
+    if (std::fabs(scaled_value) >= static_cast<double>(kMaxTickMantissa)) {
+        return false;
+    }
+    int64_t mantissa = std::llround(scaled_value);
+    int64_t tick_units = std::llround(tick_size * scale);
+    // The decimal must read back as exactly this double and lie on the grid
+    if (static_cast<double>(mantissa) / scale != value || tick_units == 0 || mantissa % tick_units != 0) {
+        return false;
+    }
+    uint64_t magnitude = mantissa < 0 ? static_cast<uint64_t>(-mantissa) : static_cast<uint64_t>(mantissa);
+    if (mantissa < 0) {
+        out.push_back('-');
+    }
+    uint64_t divisor = static_cast<uint64_t>(scale);
+    append_uint(out, magnitude / divisor);
+    out.push_back('.');
+
+    // Fraction with trailing zeros trimmed, keeping at least one digit
+    uint64_t fraction = magnitude % divisor;
+    int digits = decimals;
+    while (digits > 0 && fraction % 10 == 0) {
+        fraction /= 10;
+        --digits;
+    }
+    if (digits == 0) {
+        out.push_back('0');
+        return true;
+    }
+    char buffer[kMaxTickDecimals];
+    for (int i = digits - 1; i >= 0; --i) {
+        buffer[i] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    out.append(buffer, digits);
+    return true;
+}
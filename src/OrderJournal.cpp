@@ -0,0 +1,181 @@
+// OrderJournal.cpp
+
+#include "OrderJournal.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kMagic[8] = {'O', 'R', 'D', 'J', 'R', 'N', 'L', '1'};
+static const uint32_t kVersion = 1;
+
+static void copy_field(char* dest, size_t size, const std::string& value) {
+    size_t n = std::min(value.size(), size - 1);
+    std::memcpy(dest, value.data(), n);
+    std::memset(dest + n, 0, size - n);
+}
+
+OrderJournal::OrderJournal(const std::string& path, size_t capacity)
+    : path_(path), capacity_(std::max<size_t>(capacity, 1)), fd_(-1), mapping_(nullptr), mapping_size_(0),
+      records_(nullptr), size_(0) {
+    if (!map_file(path_)) {
+        return;
+    }
+
+    // Count the committed records; a sequence out of step marks the end
+    while (size_ < capacity_ && records_[size_].sequence == size_ + 1) {
+        ++size_;
+    }
+}
+
+OrderJournal::~OrderJournal() {
+    unmap();
+}
+
+// Map path, creating it, or resetting it if its header does not match
+bool OrderJournal::map_file(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        Logger::getInstance().log("Order journal: cannot open " + path + ": " + std::strerror(errno));
+        return false;
+    }
+
+    size_t mapping_size = (capacity_ + 1) * sizeof(Record);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        Logger::getInstance().log("Order journal: cannot stat " + path + ": " + std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+    // A journal grown by rewrite is reopened at its full size
+    if (static_cast<size_t>(st.st_size) > mapping_size) {
+        capacity_ = static_cast<size_t>(st.st_size) / sizeof(Record) - 1;
+        mapping_size = (capacity_ + 1) * sizeof(Record);
+    }
+    if (static_cast<size_t>(st.st_size) < mapping_size && ftruncate(fd, mapping_size) != 0) {
+        Logger::getInstance().log("Order journal: cannot size " + path + ": " + std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        Logger::getInstance().log("Order journal: mmap failed for " + path + ": " + std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    Header* header = static_cast<Header*>(mapping);
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion ||
+        header->record_size != sizeof(Record)) {
+        if (st.st_size > 0) {
+            Logger::getInstance().log("Order journal: " + path + " has an unknown format; starting empty.");
+        }
+        std::memset(mapping, 0, mapping_size);
+        std::memcpy(header->magic, kMagic, sizeof(kMagic));
+        header->version = kVersion;
+        header->record_size = sizeof(Record);
+    }
+    header->capacity = capacity_;
+
+    unmap();
+    fd_ = fd;
+    mapping_ = mapping;
+    mapping_size_ = mapping_size;
+    records_ = reinterpret_cast<Record*>(static_cast<char*>(mapping) + sizeof(Header));
+    size_ = 0;
+    return true;
+}
+
+void OrderJournal::unmap() {
+    if (mapping_) {
+        munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+        records_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void OrderJournal::replay(const std::function<void(const Record&)>& apply) const {
+    for (size_t i = 0; i < size_; ++i) {
+        apply(records_[i]);
+    }
+}
+
+bool OrderJournal::append(Record record) {
+    if (!records_ || size_ >= capacity_) {
+        return false;
+    }
+    record.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    write_record(record);
+    return true;
+}
+
+// Body first, then the sequence that commits it
+void OrderJournal::write_record(Record record) {
+    Record& slot = records_[size_];
+    uint64_t sequence = size_ + 1;
+    record.sequence = 0;
+    std::memcpy(&slot, &record, sizeof(Record));
+    std::atomic_ref<uint64_t>(slot.sequence).store(sequence, std::memory_order_release);
+    ++size_;
+}
+
+bool OrderJournal::rewrite(const std::vector<Record>& records) {
+    std::string tmp_path = path_ + ".tmp";
+    ::unlink(tmp_path.c_str());
+    size_t capacity = std::max(capacity_, records.size() * 2);
+    if (capacity > capacity_) {
+        Logger::getInstance().log("Order journal: " + std::to_string(records.size()) + " live records; growing " +
+                                  path_ + " to " + std::to_string(capacity) + " records.");
+    }
+    OrderJournal fresh(tmp_path, capacity);
+    if (!fresh.is_open()) {
+        return false;
+    }
+    for (const auto& record : records) {
+        fresh.write_record(record);
+    }
+    // Make the new file durable before it replaces the old one
+    if (msync(fresh.mapping_, fresh.mapping_size_, MS_SYNC) != 0 || std::rename(tmp_path.c_str(), path_.c_str()) != 0) {
+        Logger::getInstance().log("Order journal: rewrite of " + path_ + " failed: " + std::strerror(errno));
+        return false;
+    }
+
+    unmap();
+    fd_ = fresh.fd_;
+    mapping_ = fresh.mapping_;
+    mapping_size_ = fresh.mapping_size_;
+    records_ = fresh.records_;
+    size_ = fresh.size_;
+    capacity_ = fresh.capacity_;
+    fresh.fd_ = -1;
+    fresh.mapping_ = nullptr;
+    fresh.records_ = nullptr;
+    return true;
+}
+
+OrderJournal::Record OrderJournal::make_record(RecordType type, const std::string& order_id, const std::string& instrument,
+                                               const std::string& side, double quantity, double price, double filled_quantity) {
+    Record record;
+    std::memset(&record, 0, sizeof(record));
+    record.type = type;
+    record.is_sell = side == "sell";
+    record.quantity = quantity;
+    record.price = price;
+    record.filled_quantity = filled_quantity;
+    copy_field(record.order_id, sizeof(record.order_id), order_id);
+    copy_field(record.instrument, sizeof(record.instrument), instrument);
+    return record;
+}
@@ -1,14 +1,38 @@
 #include "OrderManager.hpp"
 #include "Logger.hpp"
 #include <iostream>
+#include <unordered_set>
 
-OrderManager::OrderManager(DeribitAPI& api) : api_(api) {}
+OrderManager::OrderManager(DeribitAPI& api, const PositionCache& positions, const std::string& journal_path,
+                           size_t journal_capacity)
+    : api_(api),
+      positions_(positions),
+      orders_channel_(InstrumentRegistry::getInstance().intern_channel("user.orders.any.any.raw")),
+      trades_channel_(InstrumentRegistry::getInstance().intern_channel("user.trades.any.any.raw")),
+      table_(journal_path, journal_capacity) {
+    api_.add_user_callback([this](ChannelId channel, std::string_view data) {
+        on_user_message(channel, data);
+    });
+    api_.subscribe_private({"user.orders.any.any.raw", "user.trades.any.any.raw"});
+
+    reconcile();
+
+    // Start the journal over from the reconciled state
+    std::lock_guard<std::mutex> lock(mtx_);
+    table_.checkpoint();
+    table_.publish();
+}
 
 std::string OrderManager::place_order(const std::string& instrument, const std::string& side, double quantity, double price) {
     Logger::getInstance().log("Attempting to place order: Instrument=" + instrument + ", Side=" + side + ", Quantity=" + std::to_string(quantity) + ", Price=" + std::to_string(price));
 
+    uint64_t intent_id = record_intent(instrument, side, quantity, price);
     auto response = api_.place_order(instrument, side, quantity, price);
+    return handle_place_response(intent_id, instrument, side, quantity, price, response);
+}
 
+std::string OrderManager::handle_place_response(uint64_t intent_id, const std::string& instrument, const std::string& side,
+                                                double quantity, double price, const nlohmann::json& response) {
     // Check if "result" exists and is an object
     if (response.contains("result") && response["result"].is_object()) {
         // Check if "order_id" exists
@@ -17,7 +41,9 @@ std::string OrderManager::place_order(const std::string& instrument, const std::
             std::cout << "Order ID: " << order_id << std::endl;
 
             std::lock_guard<std::mutex> lock(mtx_);
-            orders_[order_id] = Order{order_id, instrument, side, quantity, price};
+            if (table_.settle_intent(intent_id, order_id, instrument, side, quantity, price)) {
+                table_.publish();
+            }
             Logger::getInstance().log("Placed order successfully. Order ID: " + order_id);
             return order_id;
         } else {
@@ -31,6 +57,8 @@ std::string OrderManager::place_order(const std::string& instrument, const std::
         Logger::getInstance().log("place_order response missing 'result'. Response: " + response.dump());
     }
 
+    std::lock_guard<std::mutex> lock(mtx_);
+    table_.settle_intent(intent_id, "", instrument, side, quantity, price);
     return "";
 }
 
@@ -38,11 +66,17 @@ bool OrderManager::cancel_order(const std::string& order_id) {
     Logger::getInstance().log("Attempting to cancel order: Order ID=" + order_id);
     
     auto response = api_.cancel_order(order_id);
+    return handle_cancel_response(order_id, response);
+}
+
+bool OrderManager::handle_cancel_response(const std::string& order_id, const nlohmann::json& response) {
     Logger::getInstance().log("cancel_order response: " + response.dump());
-    
+
     if (response.contains("result") && response["result"].is_object()) {
         std::lock_guard<std::mutex> lock(mtx_);
-        orders_.erase(order_id);
+        if (table_.remove(order_id)) {
+            table_.publish();
+        }
         Logger::getInstance().log("Cancelled order successfully. Order ID: " + order_id);
         return true;
     } else if (response.contains("error")) {
@@ -59,13 +93,17 @@ bool OrderManager::modify_order(const std::string& order_id, double new_quantity
     Logger::getInstance().log("Attempting to modify order: Order ID=" + order_id + ", New Quantity=" + std::to_string(new_quantity) + ", New Price=" + std::to_string(new_price));
     
     auto response = api_.modify_order(order_id, new_quantity, new_price);
-    
+    return handle_modify_response(new_quantity, new_price, response);
+}
+
+bool OrderManager::handle_modify_response(double new_quantity, double new_price, const nlohmann::json& response) {
     if (response.contains("result") && response["result"].is_object()) {
         if (response["result"].contains("order") && response["result"]["order"].contains("order_id") && response["result"]["order"]["order_id"].is_string()) {
             std::string modified_order_id = response["result"]["order"]["order_id"].get<std::string>();
             std::lock_guard<std::mutex> lock(mtx_);
-            orders_[modified_order_id].quantity = new_quantity;
-            orders_[modified_order_id].price = new_price;
+            if (table_.modify(modified_order_id, new_quantity, new_price)) {
+                table_.publish();
+            }
             Logger::getInstance().log("Modified order successfully. Order ID: " + modified_order_id);
             return true;
         } else {
@@ -81,7 +119,227 @@ bool OrderManager::modify_order(const std::string& order_id, double new_quantity
     return false;
 }
 
-std::unordered_map<std::string, Order> OrderManager::get_current_orders() {
+void OrderManager::place_order_async(const std::string& instrument, const std::string& side, double quantity, double price,
+                                     std::function<void(const std::string&)> done) {
+    Logger::getInstance().log("Attempting to place order asynchronously: Instrument=" + instrument + ", Side=" + side + ", Quantity=" + std::to_string(quantity) + ", Price=" + std::to_string(price));
+
+    uint64_t intent_id = record_intent(instrument, side, quantity, price);
+    api_.place_order_async(instrument, side, quantity, price,
+        [this, intent_id, instrument, side, quantity, price, done](const nlohmann::json& response) {
+            std::string order_id = handle_place_response(intent_id, instrument, side, quantity, price, response);
+            if (done) {
+                done(order_id);
+            }
+        });
+}
+
+void OrderManager::cancel_order_async(const std::string& order_id, std::function<void(bool)> done) {
+    Logger::getInstance().log("Attempting to cancel order asynchronously: Order ID=" + order_id);
+
+    api_.cancel_order_async(order_id, [this, order_id, done](const nlohmann::json& response) {
+        bool cancelled = handle_cancel_response(order_id, response);
+        if (done) {
+            done(cancelled);
+        }
+    });
+}
+
+void OrderManager::modify_order_async(const std::string& order_id, double new_quantity, double new_price,
+                                      std::function<void(bool)> done) {
+    Logger::getInstance().log("Attempting to modify order asynchronously: Order ID=" + order_id + ", New Quantity=" + std::to_string(new_quantity) + ", New Price=" + std::to_string(new_price));
+
+    api_.modify_order_async(order_id, new_quantity, new_price,
+        [this, new_quantity, new_price, done](const nlohmann::json& response) {
+            bool modified = handle_modify_response(new_quantity, new_price, response);
+            if (done) {
+                done(modified);
+            }
+        });
+}
+
+// Order id from a buy/edit response; logs and returns "" if the request failed
+std::string OrderManager::extract_order_id(const std::string& operation, const nlohmann::json& response) {
+    if (response.contains("result") && response["result"].is_object()) {
+        const auto& result = response["result"];
+        if (result.contains("order") && result["order"].contains("order_id") && result["order"]["order_id"].is_string()) {
+            return result["order"]["order_id"].get<std::string>();
+        }
+        Logger::getInstance().log(operation + " response missing 'order_id'. Response: " + response.dump());
+    } else if (response.contains("error")) {
+        std::string error_message = response["error"].contains("message") ? response["error"]["message"].get<std::string>() : "Unknown error";
+        Logger::getInstance().log(operation + " failed. API Error: " + error_message);
+    } else {
+        Logger::getInstance().log(operation + " response missing 'result'. Response: " + response.dump());
+    }
+    return "";
+}
+
+int OrderManager::cancel_all() {
+    Logger::getInstance().log("Attempting to cancel all orders");
+    return handle_mass_cancel_response("", api_.cancel_all());
+}
+
+int OrderManager::cancel_all_by_instrument(const std::string& instrument) {
+    Logger::getInstance().log("Attempting to cancel all orders for " + instrument);
+    return handle_mass_cancel_response(instrument, api_.cancel_all_by_instrument(instrument));
+}
+
+// An empty instrument means every instrument
+int OrderManager::handle_mass_cancel_response(const std::string& instrument, const nlohmann::json& response) {
+    if (!response.contains("result") || !response["result"].is_number_integer()) {
+        Logger::getInstance().log("Mass cancel failed. Response: " + response.dump());
+        return -1;
+    }
+
+    int cancelled = response["result"].get<int>();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (const auto& order_id : table_.order_ids(instrument)) {
+            table_.remove(order_id);
+        }
+        table_.publish();
+    }
+    Logger::getInstance().log("Mass cancel complete" + (instrument.empty() ? std::string() : " for " + instrument) +
+                              ". Orders cancelled: " + std::to_string(cancelled));
+    return cancelled;
+}
+
+std::vector<std::string> OrderManager::place_orders(const std::vector<OrderRequest>& requests) {
+    std::vector<std::future<nlohmann::json>> responses;
+    std::vector<uint64_t> intent_ids;
+    responses.reserve(requests.size());
+    intent_ids.reserve(requests.size());
+    for (const auto& request : requests) {
+        intent_ids.push_back(record_intent(request.instrument, request.side, request.quantity, request.price));
+        responses.push_back(api_.place_order_async(request.instrument, request.side, request.quantity, request.price));
+    }
+
+    std::vector<std::string> order_ids(requests.size());
+    for (size_t i = 0; i < requests.size(); ++i) {
+        order_ids[i] = extract_order_id("place_order", responses[i].get());
+    }
+
+    size_t placed = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (size_t i = 0; i < requests.size(); ++i) {
+            const auto& request = requests[i];
+            table_.settle_intent(intent_ids[i], order_ids[i], request.instrument, request.side, request.quantity, request.price);
+            if (!order_ids[i].empty()) {
+                ++placed;
+            }
+        }
+        table_.publish();
+    }
+    Logger::getInstance().log("Batch place: " + std::to_string(placed) + " of " + std::to_string(requests.size()) + " orders placed.");
+    return order_ids;
+}
+
+std::vector<bool> OrderManager::modify_orders(const std::vector<OrderModification>& modifications) {
+    std::vector<std::future<nlohmann::json>> responses;
+    responses.reserve(modifications.size());
+    for (const auto& modification : modifications) {
+        responses.push_back(api_.modify_order_async(modification.order_id, modification.new_quantity, modification.new_price));
+    }
+
+    std::vector<std::string> order_ids(modifications.size());
+    for (size_t i = 0; i < modifications.size(); ++i) {
+        order_ids[i] = extract_order_id("modify_order", responses[i].get());
+    }
+
+    std::vector<bool> modified(modifications.size(), false);
+    size_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (size_t i = 0; i < modifications.size(); ++i) {
+            if (order_ids[i].empty()) {
+                continue;
+            }
+            table_.modify(order_ids[i], modifications[i].new_quantity, modifications[i].new_price);
+            modified[i] = true;
+            ++count;
+        }
+        table_.publish();
+    }
+    Logger::getInstance().log("Batch modify: " + std::to_string(count) + " of " + std::to_string(modifications.size()) + " orders modified.");
+    return modified;
+}
+
+std::shared_ptr<const OrderSnapshot> OrderManager::get_current_orders() const {
+    return table_.snapshot();
+}
+
+bool OrderManager::get_position(const std::string& instrument, Position& position) const {
+    return positions_.get_position(instrument, position);
+}
+
+void OrderManager::on_user_message(ChannelId channel, std::string_view data) {
+    if (channel != orders_channel_ && channel != trades_channel_) {
+        return;
+    }
+    try {
+        nlohmann::json payload = nlohmann::json::parse(data);
+        // Raw channels carry one object; aggregated intervals carry an array
+        std::vector<nlohmann::json> items;
+        if (payload.is_array()) {
+            items = payload.get<std::vector<nlohmann::json>>();
+        } else {
+            items.push_back(std::move(payload));
+        }
+
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (const auto& item : items) {
+            if (channel == orders_channel_) {
+                table_.apply_order_update(item);
+            } else {
+                table_.apply_trade(item);
+            }
+        }
+        table_.publish();
+    } catch (const std::exception& e) {
+        Logger::getInstance().log("Order notification parse error: " + std::string(e.what()));
+    }
+}
+
+// Bring the table in line with the exchange: orders that closed while we were
+// down are dropped, orders we did not know about are added
+void OrderManager::reconcile() {
+    nlohmann::json response = api_.get_open_orders();
+    if (!response.contains("result") || !response["result"].is_array()) {
+        Logger::getInstance().log("Order reconciliation skipped; private/get_open_orders failed: " + response.dump());
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::unordered_set<std::string> live;
+    size_t added = 0;
+    for (const auto& order : response["result"]) {
+        if (!order.contains("order_id") || !order["order_id"].is_string()) {
+            continue;
+        }
+        std::string order_id = order["order_id"].get<std::string>();
+        live.insert(order_id);
+        if (!table_.contains(order_id)) {
+            ++added;
+        }
+        table_.apply_order_update(order);
+    }
+
+    std::vector<std::string> closed;
+    for (const auto& order_id : table_.order_ids()) {
+        if (live.find(order_id) == live.end()) {
+            closed.push_back(order_id);
+        }
+    }
+    for (const auto& order_id : closed) {
+        table_.remove(order_id);
+    }
+    table_.publish();
+    Logger::getInstance().log("Orders reconciled with the exchange: " + std::to_string(live.size()) + " open, " +
+                              std::to_string(added) + " added, " + std::to_string(closed.size()) + " closed while offline.");
+}
+
+uint64_t OrderManager::record_intent(const std::string& instrument, const std::string& side, double quantity, double price) {
     std::lock_guard<std::mutex> lock(mtx_);
-    return orders_;
+    return table_.record_intent(instrument, side, quantity, price);
 }
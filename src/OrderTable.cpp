@@ -0,0 +1,274 @@
+// OrderTable.cpp
+
+#include "OrderTable.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+OrderTable::OrderTable(const std::string& journal_path, size_t journal_capacity)
+    : next_intent_id_(1),
+      snapshot_(std::make_shared<const OrderSnapshot>()) {
+    if (!journal_path.empty()) {
+        auto journal = std::make_unique<OrderJournal>(journal_path, journal_capacity);
+        if (journal->is_open()) {
+            replay(*journal);
+            journal_ = std::move(journal);
+        }
+    }
+}
+
+uint64_t OrderTable::record_intent(const std::string& instrument, const std::string& side, double quantity, double price) {
+    if (!journal_) {
+        return 0;
+    }
+    auto record = OrderJournal::make_record(OrderJournal::RecordType::Intent, "", instrument, side, quantity, price);
+    record.intent_id = next_intent_id_++;
+    intents_[record.intent_id] = record;
+    journal(record);
+    return record.intent_id;
+}
+
+bool OrderTable::settle_intent(uint64_t intent_id, const std::string& order_id, const std::string& instrument,
+                               const std::string& side, double quantity, double price) {
+    intents_.erase(intent_id);
+    SlotEntry* entry = order_id.empty() ? nullptr : upsert(order_id, instrument, side, quantity, price);
+    if (entry) {
+        // Its Open record, written on publish, acknowledges the intent
+        entry->intent_id = intent_id;
+        return true;
+    }
+    if (intent_id != 0) {
+        // No Open record will follow, so close the intent for the replay
+        auto record = OrderJournal::make_record(OrderJournal::RecordType::Closed, order_id, instrument, side, quantity, price);
+        record.intent_id = intent_id;
+        journal(record);
+    }
+    return false;
+}
+
+bool OrderTable::modify(const std::string& order_id, double quantity, double price) {
+    SlotEntry* entry = find(order_id);
+    if (!entry) {
+        return false;
+    }
+    entry->order.quantity = quantity;
+    entry->order.price = price;
+    entry->dirty = true;
+    return true;
+}
+
+bool OrderTable::remove(const std::string& order_id) {
+    if (recently_closed_.insert(order_id).second) {
+        recently_closed_order_.push_back(order_id);
+        if (recently_closed_order_.size() > kMaxRecentlyClosed) {
+            recently_closed_.erase(recently_closed_order_.front());
+            recently_closed_order_.pop_front();
+        }
+    }
+
+    auto it = slot_by_order_id_.find(order_id);
+    if (it == slot_by_order_id_.end()) {
+        return false;
+    }
+    // Out of the table before it is journaled, so a compaction does not keep it
+    SlotEntry& entry = slots_[it->second];
+    entry.active = false;
+    free_slots_.push_back(it->second);
+    slot_by_order_id_.erase(it);
+    journal(OrderJournal::make_record(OrderJournal::RecordType::Closed, order_id, entry.order.instrument, entry.order.side,
+                                      entry.order.quantity, entry.order.price, entry.order.filled_quantity));
+    return true;
+}
+
+std::vector<std::string> OrderTable::order_ids(const std::string& instrument) const {
+    std::vector<std::string> order_ids;
+    for (const auto& entry : slots_) {
+        if (entry.active && (instrument.empty() || entry.order.instrument == instrument)) {
+            order_ids.push_back(entry.order.order_id);
+        }
+    }
+    return order_ids;
+}
+
+// Terminal states drop the order
+void OrderTable::apply_order_update(const nlohmann::json& order) {
+    if (!order.contains("order_id") || !order["order_id"].is_string()) {
+        return;
+    }
+    std::string order_id = order["order_id"].get<std::string>();
+    std::string state = order.value("order_state", "");
+
+    if (state == "filled" || state == "cancelled" || state == "rejected") {
+        if (remove(order_id)) {
+            Logger::getInstance().log("Order " + order_id + " closed by exchange: " + state);
+        }
+        return;
+    }
+
+    SlotEntry* entry = find(order_id);
+    double quantity = order.value("amount", entry ? entry->order.quantity : 0.0);
+    // Market orders report price as the string "market_price"
+    double price = order.contains("price") && order["price"].is_number() ? order["price"].get<double>()
+                                                                         : (entry ? entry->order.price : 0.0);
+    entry = upsert(order_id, order.value("instrument_name", ""), order.value("direction", ""), quantity, price);
+    if (entry && order.contains("filled_amount") && order["filled_amount"].is_number()) {
+        entry->order.filled_quantity = std::max(order["filled_amount"].get<double>(), entry->trade_filled);
+    }
+}
+
+// Usually ahead of the matching user.orders update
+void OrderTable::apply_trade(const nlohmann::json& trade) {
+    if (!trade.contains("order_id") || !trade["order_id"].is_string()) {
+        return;
+    }
+    std::string order_id = trade["order_id"].get<std::string>();
+    if (trade.value("state", "") == "filled") {
+        if (remove(order_id)) {
+            Logger::getInstance().log("Order " + order_id + " filled.");
+        }
+        return;
+    }
+    if (SlotEntry* entry = find(order_id)) {
+        entry->trade_filled += trade.value("amount", 0.0);
+        entry->order.filled_quantity = std::max(entry->order.filled_quantity, entry->trade_filled);
+        entry->dirty = true;
+    }
+}
+
+// Copy-on-write: readers keep whichever snapshot they loaded; the old one is
+// freed when its last reader drops it
+void OrderTable::publish() {
+    auto snapshot = std::make_shared<OrderSnapshot>();
+    snapshot->reserve(slot_by_order_id_.size());
+    for (auto& entry : slots_) {
+        if (!entry.active) {
+            continue;
+        }
+        snapshot->push_back(entry.order);
+        if (entry.dirty) {
+            entry.dirty = false;
+            auto record = OrderJournal::make_record(OrderJournal::RecordType::Open, entry.order.order_id, entry.order.instrument,
+                                                    entry.order.side, entry.order.quantity, entry.order.price,
+                                                    entry.order.filled_quantity);
+            record.intent_id = entry.intent_id;
+            journal(record);
+        }
+    }
+    snapshot_.store(std::move(snapshot), std::memory_order_release);
+}
+
+// Unsettled intents first, so each precedes the Open record of its order
+void OrderTable::checkpoint() {
+    if (!journal_) {
+        return;
+    }
+    std::vector<OrderJournal::Record> records;
+    records.reserve(intents_.size() + slot_by_order_id_.size());
+    for (const auto& [intent_id, record] : intents_) {
+        records.push_back(record);
+    }
+    for (auto& entry : slots_) {
+        if (!entry.active) {
+            continue;
+        }
+        auto record = OrderJournal::make_record(OrderJournal::RecordType::Open, entry.order.order_id, entry.order.instrument,
+                                                entry.order.side, entry.order.quantity, entry.order.price,
+                                                entry.order.filled_quantity);
+        record.intent_id = entry.intent_id;
+        records.push_back(record);
+        entry.dirty = false;
+    }
+    if (!journal_->rewrite(records)) {
+        Logger::getInstance().log("Order journal could not be compacted; journaling disabled.");
+        journal_.reset();
+    }
+}
+
+OrderTable::SlotEntry* OrderTable::find(const std::string& order_id) {
+    auto it = slot_by_order_id_.find(order_id);
+    return it == slot_by_order_id_.end() ? nullptr : &slots_[it->second];
+}
+
+// Insert or refresh an open order, keeping its fill; returns null if the order
+// is already known to be closed
+OrderTable::SlotEntry* OrderTable::upsert(const std::string& order_id, const std::string& instrument,
+                                          const std::string& side, double quantity, double price) {
+    if (recently_closed_.count(order_id)) {
+        return nullptr;
+    }
+    SlotEntry* entry = find(order_id);
+    if (!entry) {
+        OrderSlot slot;
+        if (!free_slots_.empty()) {
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+        } else {
+            slot = static_cast<OrderSlot>(slots_.size());
+            slots_.emplace_back();
+        }
+        slot_by_order_id_[order_id] = slot;
+        entry = &slots_[slot];
+        *entry = SlotEntry();
+        entry->order.order_id = order_id;
+        entry->active = true;
+    }
+    if (!instrument.empty()) {
+        entry->order.instrument = instrument;
+    }
+    if (!side.empty()) {
+        entry->order.side = side;
+    }
+    entry->order.quantity = quantity;
+    entry->order.price = price;
+    entry->dirty = true;
+    return entry;
+}
+
+// Rebuild the table from a journal left by a previous run
+void OrderTable::replay(OrderJournal& journal) {
+    auto start = std::chrono::steady_clock::now();
+
+    journal.replay([this](const OrderJournal::Record& record) {
+        next_intent_id_ = std::max(next_intent_id_, record.intent_id + 1);
+        std::string order_id(record.order_id, strnlen(record.order_id, sizeof(record.order_id)));
+        switch (record.type) {
+        case OrderJournal::RecordType::Intent:
+            intents_[record.intent_id] = record;
+            break;
+        case OrderJournal::RecordType::Open:
+            intents_.erase(record.intent_id);
+            if (SlotEntry* entry = upsert(order_id, std::string(record.instrument, strnlen(record.instrument, sizeof(record.instrument))),
+                                          record.is_sell ? "sell" : "buy", record.quantity, record.price)) {
+                entry->order.filled_quantity = record.filled_quantity;
+                entry->intent_id = record.intent_id;
+            }
+            break;
+        case OrderJournal::RecordType::Closed:
+            intents_.erase(record.intent_id);
+            if (!order_id.empty()) {
+                remove(order_id);
+            }
+            break;
+        }
+    });
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    Logger::getInstance().log("Order journal replayed: " + std::to_string(journal.size()) + " records, " +
+                              std::to_string(slot_by_order_id_.size()) + " open orders in " +
+                              std::to_string(elapsed.count() / 1000.0) + " ms.");
+    if (!intents_.empty()) {
+        // Sent but never answered before the restart; reconciliation shows whether they exist
+        Logger::getInstance().log("Order journal: " + std::to_string(intents_.size()) +
+                                  " order intent(s) were never acknowledged.");
+    }
+}
+
+// Full: compact to the live state, which callers update before journaling, so
+// the rewrite already includes this record's change
+void OrderTable::journal(const OrderJournal::Record& record) {
+    if (!journal_ || journal_->append(record)) {
+        return;
+    }
+    checkpoint();
+}
@@ -0,0 +1,235 @@
+// PositionCache.cpp
+
+#include "PositionCache.hpp"
+#include "Logger.hpp"
+#include <chrono>
+#include <cmath>
+#include <unordered_set>
+
+static const char* const kChangesChannel = "user.changes.any.any.raw";
+static const char* const kPortfolioChannel = "user.portfolio.any";
+
+// Sizes closer than this are treated as equal when checking for drift
+static const double kDriftTolerance = 1e-9;
+
+static void parse_position(const nlohmann::json& data, Position& position) {
+    position.size = data.value("size", position.size);
+    position.average_price = data.value("average_price", position.average_price);
+    position.mark_price = data.value("mark_price", position.mark_price);
+    position.floating_pnl = data.value("floating_profit_loss", position.floating_pnl);
+    position.realized_pnl = data.value("realized_profit_loss", position.realized_pnl);
+    position.delta = data.value("delta", position.delta);
+}
+
+PositionCache::PositionCache(DeribitAPI& api, int reconcile_interval_s)
+    : api_(api),
+      changes_channel_(InstrumentRegistry::getInstance().intern_channel(kChangesChannel)),
+      portfolio_channel_(InstrumentRegistry::getInstance().intern_channel(kPortfolioChannel)),
+      entries_(new std::atomic<Entry*>[InstrumentRegistry::kMaxInstruments]),
+      stream_seq_(0), reconcile_interval_s_(reconcile_interval_s), running_(true) {
+    for (size_t i = 0; i < InstrumentRegistry::kMaxInstruments; ++i) {
+        entries_[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    // Subscribe before the snapshot so no change between the two is missed
+    api_.add_user_callback([this](ChannelId channel, std::string_view data) {
+        on_user_message(channel, data);
+    });
+    api_.subscribe_private({kChangesChannel, kPortfolioChannel});
+    reconcile();
+
+    if (reconcile_interval_s_ > 0) {
+        reconcile_thread_ = std::thread(&PositionCache::run_reconcile, this);
+    }
+}
+
+PositionCache::~PositionCache() {
+    {
+        std::lock_guard<std::mutex> lock(reconcile_mtx_);
+        running_ = false;
+    }
+    reconcile_cv_.notify_all();
+    if (reconcile_thread_.joinable()) {
+        reconcile_thread_.join();
+    }
+}
+
+PositionCache::Entry* PositionCache::find_entry(const std::string& instrument) const {
+    InstrumentId id = InstrumentRegistry::getInstance().find_instrument(instrument);
+    if (id == kInvalidId) {
+        return nullptr;
+    }
+    return entries_[id].load(std::memory_order_acquire);
+}
+
+PositionCache::Entry& PositionCache::get_or_create_entry(InstrumentId instrument) {
+    Entry* entry = entries_[instrument].load(std::memory_order_acquire);
+    if (entry) {
+        return *entry;
+    }
+
+    std::lock_guard<std::mutex> lock(entries_mtx_);
+    entry = entries_[instrument].load(std::memory_order_relaxed);
+    if (!entry) {
+        owned_entries_.push_back(std::make_unique<Entry>());
+        entry = owned_entries_.back().get();
+        entry->position.instrument = InstrumentRegistry::getInstance().instrument_name(instrument);
+        entries_[instrument].store(entry, std::memory_order_release);
+    }
+    return *entry;
+}
+
+bool PositionCache::get_position(const std::string& instrument, Position& position) const {
+    Entry* entry = find_entry(instrument);
+    if (!entry) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(entry->mtx);
+    position = entry->position;
+    return true;
+}
+
+std::vector<Position> PositionCache::get_positions() const {
+    std::vector<Position> positions;
+    std::lock_guard<std::mutex> lock(entries_mtx_);
+    for (const auto& entry : owned_entries_) {
+        std::lock_guard<std::mutex> entry_lock(entry->mtx);
+        if (entry->position.size != 0.0) {
+            positions.push_back(entry->position);
+        }
+    }
+    return positions;
+}
+
+bool PositionCache::get_portfolio(const std::string& currency, Portfolio& portfolio) const {
+    std::lock_guard<std::mutex> lock(portfolio_mtx_);
+    auto it = portfolios_.find(currency);
+    if (it == portfolios_.end()) {
+        return false;
+    }
+    portfolio = it->second;
+    return true;
+}
+
+void PositionCache::on_user_message(ChannelId channel, std::string_view data) {
+    if (channel != changes_channel_ && channel != portfolio_channel_) {
+        return;
+    }
+    try {
+        nlohmann::json payload = nlohmann::json::parse(data);
+        if (channel == portfolio_channel_) {
+            apply_portfolio(payload);
+            return;
+        }
+        // user.changes carries the trades, orders and positions touched by one event
+        if (payload.contains("positions") && payload["positions"].is_array()) {
+            for (const auto& position : payload["positions"]) {
+                apply_position(position, stream_seq_.fetch_add(1, std::memory_order_acq_rel) + 1);
+            }
+        }
+    } catch (const std::exception& e) {
+        Logger::getInstance().log("Position notification parse error: " + std::string(e.what()));
+    }
+}
+
+void PositionCache::apply_position(const nlohmann::json& data, uint64_t stream_seq) {
+    if (!data.contains("instrument_name") || !data["instrument_name"].is_string()) {
+        return;
+    }
+    InstrumentId id = InstrumentRegistry::getInstance().intern_instrument(data["instrument_name"].get<std::string>());
+    if (id == kInvalidId) {
+        return;
+    }
+    Entry& entry = get_or_create_entry(id);
+    std::lock_guard<std::mutex> lock(entry.mtx);
+    parse_position(data, entry.position);
+    entry.stream_seq = stream_seq;
+}
+
+void PositionCache::apply_portfolio(const nlohmann::json& data) {
+    if (!data.contains("currency") || !data["currency"].is_string()) {
+        return;
+    }
+    std::string currency = data["currency"].get<std::string>();
+    std::lock_guard<std::mutex> lock(portfolio_mtx_);
+    Portfolio& portfolio = portfolios_[currency];
+    portfolio.currency = currency;
+    portfolio.equity = data.value("equity", portfolio.equity);
+    portfolio.balance = data.value("balance", portfolio.balance);
+    portfolio.margin_balance = data.value("margin_balance", portfolio.margin_balance);
+    portfolio.available_funds = data.value("available_funds", portfolio.available_funds);
+    portfolio.initial_margin = data.value("initial_margin", portfolio.initial_margin);
+    portfolio.maintenance_margin = data.value("maintenance_margin", portfolio.maintenance_margin);
+    portfolio.total_pl = data.value("total_pl", portfolio.total_pl);
+}
+
+// An entry streamed after the REST request went out is newer than the
+// response, so it is left alone
+void PositionCache::reconcile() {
+    uint64_t started = stream_seq_.load(std::memory_order_acquire);
+    nlohmann::json response = api_.get_positions();
+    if (!response.contains("result") || !response["result"].is_array()) {
+        Logger::getInstance().log("Position reconciliation failed: " + response.dump());
+        return;
+    }
+
+    std::unordered_set<InstrumentId> reported;
+    size_t drifted = 0;
+    for (const auto& data : response["result"]) {
+        if (!data.contains("instrument_name") || !data["instrument_name"].is_string()) {
+            continue;
+        }
+        std::string instrument = data["instrument_name"].get<std::string>();
+        InstrumentId id = InstrumentRegistry::getInstance().intern_instrument(instrument);
+        if (id == kInvalidId) {
+            continue;
+        }
+        reported.insert(id);
+
+        Entry& entry = get_or_create_entry(id);
+        std::lock_guard<std::mutex> lock(entry.mtx);
+        if (entry.stream_seq > started) {
+            continue;
+        }
+        double cached = entry.position.size;
+        parse_position(data, entry.position);
+        if (std::fabs(cached - entry.position.size) > kDriftTolerance) {
+            ++drifted;
+            Logger::getInstance().log("Position drift on " + instrument + ": cached " + std::to_string(cached) +
+                                      ", exchange " + std::to_string(entry.position.size));
+        }
+    }
+
+    // Anything the exchange no longer reports is flat
+    std::lock_guard<std::mutex> lock(entries_mtx_);
+    for (const auto& entry : owned_entries_) {
+        InstrumentId id = InstrumentRegistry::getInstance().find_instrument(entry->position.instrument);
+        if (reported.count(id)) {
+            continue;
+        }
+        std::lock_guard<std::mutex> entry_lock(entry->mtx);
+        if (entry->stream_seq <= started && entry->position.size != 0.0) {
+            ++drifted;
+            Logger::getInstance().log("Position drift on " + entry->position.instrument + ": cached " +
+                                      std::to_string(entry->position.size) + ", exchange reports none");
+            entry->position = Position{entry->position.instrument};
+        }
+    }
+
+    if (drifted > 0) {
+        Logger::getInstance().log("Position reconciliation corrected " + std::to_string(drifted) + " position(s).");
+    }
+}
+
+void PositionCache::run_reconcile() {
+    std::unique_lock<std::mutex> lock(reconcile_mtx_);
+    while (running_) {
+        reconcile_cv_.wait_for(lock, std::chrono::seconds(reconcile_interval_s_), [this] { return !running_; });
+        if (!running_) {
+            break;
+        }
+        lock.unlock();
+        reconcile();
+        lock.lock();
+    }
+}
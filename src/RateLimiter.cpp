@@ -0,0 +1,203 @@
+// RateLimiter.cpp
+
+#include "RateLimiter.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+RateLimiter::RateLimiter(Limits matching_engine, Limits non_matching, double cancel_reserve, int max_queue_ms)
+    : max_queue_(max_queue_ms), running_(true), immediate_(0), queued_(0), shed_(0), throttled_(0) {
+    auto now = std::chrono::steady_clock::now();
+    for (Bucket* b : {&matching_engine_, &non_matching_}) {
+        b->limits = b == &matching_engine_ ? matching_engine : non_matching;
+        b->limits.rate = std::max(b->limits.rate, 0.001);
+        b->limits.burst = std::max(b->limits.burst, 1.0);
+        b->credits = b->limits.burst;
+        b->updated = now;
+    }
+    // Only matching engine requests can be cancels; keep at least one credit for new orders
+    matching_engine_.reserve = std::clamp(cancel_reserve, 0.0, matching_engine_.limits.burst - 1.0);
+    non_matching_.reserve = 0.0;
+
+    thread_ = std::thread(&RateLimiter::run, this);
+}
+
+RateLimiter::~RateLimiter() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void RateLimiter::refill_locked(Bucket& b, std::chrono::steady_clock::time_point now) {
+    std::chrono::duration<double> elapsed = now - b.updated;
+    b.credits = std::min(b.limits.burst, b.credits + elapsed.count() * b.limits.rate);
+    b.updated = now;
+}
+
+// Nothing may overtake a queued request of the same or higher priority
+bool RateLimiter::take_locked(Bucket& b, Priority priority) {
+    if (!b.cancels.empty()) {
+        return false;
+    }
+    double needed = 1.0;
+    if (priority == Priority::Normal) {
+        if (!b.normal.empty()) {
+            return false;
+        }
+        needed += b.reserve;
+    }
+    if (b.credits < needed) {
+        return false;
+    }
+    b.credits -= 1.0;
+    return true;
+}
+
+bool RateLimiter::try_acquire(Pool pool, Priority priority) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Bucket& b = bucket(pool);
+    refill_locked(b, std::chrono::steady_clock::now());
+    if (!running_ || !take_locked(b, priority)) {
+        return false;
+    }
+    immediate_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void RateLimiter::submit(Pool pool, Priority priority, Task task) {
+    bool admitted = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        Bucket& b = bucket(pool);
+        refill_locked(b, std::chrono::steady_clock::now());
+        if (running_ && take_locked(b, priority)) {
+            admitted = true;
+        } else if (running_ && priority == Priority::Cancel) {
+            b.cancels.push_back(std::move(task));
+            queued_.fetch_add(1, std::memory_order_relaxed);
+            cv_.notify_one();
+            return;
+        } else if (running_) {
+            // Time until every request ahead of this one, and this one, has credit
+            double deficit = static_cast<double>(b.cancels.size() + b.normal.size()) + 1.0 + b.reserve - b.credits;
+            std::chrono::duration<double> wait(deficit / b.limits.rate);
+            if (wait <= max_queue_) {
+                b.normal.push_back(std::move(task));
+                queued_.fetch_add(1, std::memory_order_relaxed);
+                cv_.notify_one();
+                return;
+            }
+        }
+    }
+
+    if (admitted) {
+        immediate_.fetch_add(1, std::memory_order_relaxed);
+        task(true);
+        return;
+    }
+    uint64_t shed = shed_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (shed == 1 || shed % 1000 == 0) {
+        Logger::getInstance().log(std::string("Rate limit: shedding ") +
+                                  (pool == Pool::MatchingEngine ? "matching engine" : "non-matching") +
+                                  " request locally, total shed: " + std::to_string(shed));
+    }
+    task(false);
+}
+
+void RateLimiter::on_throttled(Pool pool) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        Bucket& b = bucket(pool);
+        refill_locked(b, std::chrono::steady_clock::now());
+        b.credits = std::min(b.credits, 0.0);
+    }
+    uint64_t throttled = throttled_.fetch_add(1, std::memory_order_relaxed) + 1;
+    Logger::getInstance().log("Exchange returned too_many_requests (" + std::to_string(throttled) +
+                              " so far); draining the local " +
+                              (pool == Pool::MatchingEngine ? "matching engine" : "non-matching") + " bucket.");
+}
+
+// How long until the head of the bucket's queue can be released
+std::chrono::steady_clock::duration RateLimiter::next_release_locked(const Bucket& b) const {
+    double needed;
+    if (!b.cancels.empty()) {
+        needed = 1.0;
+    } else if (!b.normal.empty()) {
+        needed = 1.0 + b.reserve;
+    } else {
+        return std::chrono::steady_clock::duration::max();
+    }
+    std::chrono::duration<double> wait(std::max(needed - b.credits, 0.0) / b.limits.rate);
+    return std::max<std::chrono::steady_clock::duration>(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(wait), std::chrono::microseconds(100));
+}
+
+void RateLimiter::run() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (running_) {
+        auto now = std::chrono::steady_clock::now();
+        std::vector<Task> ready;
+        for (Bucket* b : {&matching_engine_, &non_matching_}) {
+            refill_locked(*b, now);
+            while (!b->cancels.empty() && b->credits >= 1.0) {
+                b->credits -= 1.0;
+                ready.push_back(std::move(b->cancels.front()));
+                b->cancels.pop_front();
+            }
+            while (b->cancels.empty() && !b->normal.empty() && b->credits >= 1.0 + b->reserve) {
+                b->credits -= 1.0;
+                ready.push_back(std::move(b->normal.front()));
+                b->normal.pop_front();
+            }
+        }
+
+        if (!ready.empty()) {
+            // Send outside the lock; callers may submit again from inside a task
+            lock.unlock();
+            for (auto& task : ready) {
+                task(true);
+            }
+            lock.lock();
+            continue;
+        }
+
+        auto wait = std::min(next_release_locked(matching_engine_), next_release_locked(non_matching_));
+        if (wait == std::chrono::steady_clock::duration::max()) {
+            cv_.wait(lock);
+        } else {
+            cv_.wait_for(lock, wait);
+        }
+    }
+
+    // Stopped: fail whatever is still waiting
+    std::vector<Task> pending;
+    for (Bucket* b : {&matching_engine_, &non_matching_}) {
+        for (auto& task : b->cancels) {
+            pending.push_back(std::move(task));
+        }
+        for (auto& task : b->normal) {
+            pending.push_back(std::move(task));
+        }
+        b->cancels.clear();
+        b->normal.clear();
+    }
+    lock.unlock();
+    for (auto& task : pending) {
+        task(false);
+    }
+}
+
+RateLimiter::Stats RateLimiter::get_stats() const {
+    Stats stats;
+    stats.immediate = immediate_.load(std::memory_order_relaxed);
+    stats.queued = queued_.load(std::memory_order_relaxed);
+    stats.shed = shed_.load(std::memory_order_relaxed);
+    stats.throttled = throttled_.load(std::memory_order_relaxed);
+    return stats;
+}
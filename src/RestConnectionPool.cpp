@@ -0,0 +1,189 @@
+// RestConnectionPool.cpp
+
+#include "RestConnectionPool.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+
+// Cheap unauthenticated request used to open and keep connections alive
+static const char* kPingBody = "{\"id\":0,\"jsonrpc\":\"2.0\",\"method\":\"public/test\",\"params\":{}}";
+
+// Helper function to write response data
+static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp)
+{
+    ((std::string*)userp)->append((char*)contents, size * nmemb);
+    return size * nmemb;
+}
+
+RestConnectionPool::RestConnectionPool(const std::string& url, size_t pool_size, int keepalive_ping_ms)
+    : url_(url), keepalive_ping_(keepalive_ping_ms), share_(curl_share_init()), running_(false) {
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, &RestConnectionPool::lock_share);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, &RestConnectionPool::unlock_share);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    handles_.resize(std::max<size_t>(pool_size, 1));
+    for (size_t i = 0; i < handles_.size(); ++i) {
+        Handle& handle = handles_[i];
+        handle.curl = curl_easy_init();
+        handle.headers = curl_slist_append(nullptr, "Content-Type: application/json");
+
+        // Everything except the body and headers is set once for the handle's lifetime
+        curl_easy_setopt(handle.curl, CURLOPT_URL, url_.c_str());
+        curl_easy_setopt(handle.curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+        curl_easy_setopt(handle.curl, CURLOPT_SHARE, share_);
+        curl_easy_setopt(handle.curl, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(handle.curl, CURLOPT_CONNECTTIMEOUT_MS, 5000L);
+        curl_easy_setopt(handle.curl, CURLOPT_TCP_NODELAY, 1L);
+        curl_easy_setopt(handle.curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(handle.curl, CURLOPT_TCP_KEEPIDLE, 30L);
+        curl_easy_setopt(handle.curl, CURLOPT_TCP_KEEPINTVL, 10L);
+        curl_easy_setopt(handle.curl, CURLOPT_DNS_CACHE_TIMEOUT, 600L);
+        curl_easy_setopt(handle.curl, CURLOPT_MAXCONNECTS, 1L);
+        free_handles_.push_back(i);
+    }
+}
+
+RestConnectionPool::~RestConnectionPool() {
+    {
+        std::lock_guard<std::mutex> lock(pool_mtx_);
+        running_ = false;
+    }
+    ping_cv_.notify_all();
+    if (ping_thread_.joinable()) {
+        ping_thread_.join();
+    }
+
+    for (auto& handle : handles_) {
+        curl_easy_cleanup(handle.curl);
+        curl_slist_free_all(handle.headers);
+        curl_slist_free_all(handle.auth_headers);
+    }
+    curl_share_cleanup(share_);
+}
+
+void RestConnectionPool::lock_share(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+    static_cast<RestConnectionPool*>(userptr)->share_mtx_[data].lock();
+}
+
+void RestConnectionPool::unlock_share(CURL*, curl_lock_data data, void* userptr) {
+    static_cast<RestConnectionPool*>(userptr)->share_mtx_[data].unlock();
+}
+
+void RestConnectionPool::warm_up() {
+    // Take every handle at once so each opens its own connection
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < handles_.size(); ++i) {
+        indices.push_back(acquire());
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t index : indices) {
+        threads.emplace_back([this, index]() {
+            std::string response;
+            if (!perform(handles_[index], kPingBody, std::string(), response)) {
+                Logger::getInstance().log("REST connection warm-up failed for handle " + std::to_string(index));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (size_t index : indices) {
+        release(index);
+    }
+    Logger::getInstance().log("REST connection pool warmed with " + std::to_string(handles_.size()) + " connection(s).");
+
+    std::lock_guard<std::mutex> lock(pool_mtx_);
+    if (!running_ && keepalive_ping_.count() > 0) {
+        running_ = true;
+        ping_thread_ = std::thread(&RestConnectionPool::ping_idle_handles, this);
+    }
+}
+
+size_t RestConnectionPool::acquire() {
+    std::unique_lock<std::mutex> lock(pool_mtx_);
+    pool_cv_.wait(lock, [this]() { return !free_handles_.empty(); });
+    // Most recently used first: its connection is the least likely to have gone stale
+    size_t index = free_handles_.back();
+    free_handles_.pop_back();
+    return index;
+}
+
+void RestConnectionPool::release(size_t index) {
+    {
+        std::lock_guard<std::mutex> lock(pool_mtx_);
+        free_handles_.push_back(index);
+    }
+    pool_cv_.notify_all();
+}
+
+bool RestConnectionPool::post(const std::string& body, const std::string& auth_token, std::string& response) {
+    size_t index = acquire();
+    bool ok = perform(handles_[index], body, auth_token, response);
+    release(index);
+    return ok;
+}
+
+bool RestConnectionPool::perform(Handle& handle, const std::string& body, const std::string& auth_token, std::string& response) {
+    curl_slist* headers = handle.headers;
+    if (!auth_token.empty()) {
+        // The header list is rebuilt only when the token changes
+        if (auth_token != handle.auth_token) {
+            curl_slist_free_all(handle.auth_headers);
+            handle.auth_headers = curl_slist_append(nullptr, "Content-Type: application/json");
+            handle.auth_headers = curl_slist_append(handle.auth_headers, ("Authorization: Bearer " + auth_token).c_str());
+            handle.auth_token = auth_token;
+        }
+        headers = handle.auth_headers;
+    }
+
+    response.clear();
+    curl_easy_setopt(handle.curl, CURLOPT_POSTFIELDS, body.c_str());
+    curl_easy_setopt(handle.curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.size()));
+    curl_easy_setopt(handle.curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(handle.curl, CURLOPT_WRITEDATA, &response);
+
+    CURLcode res = curl_easy_perform(handle.curl);
+    handle.last_used = std::chrono::steady_clock::now();
+    if (res != CURLE_OK) {
+        Logger::getInstance().log("CURL error: " + std::string(curl_easy_strerror(res)));
+        response.clear();
+        return false;
+    }
+    return true;
+}
+
+void RestConnectionPool::ping_idle_handles() {
+    std::unique_lock<std::mutex> lock(pool_mtx_);
+    while (running_) {
+        ping_cv_.wait_for(lock, keepalive_ping_ / 2);
+        if (!running_) {
+            break;
+        }
+
+        // Pull out the idle handles; busy ones are being kept warm by real traffic
+        auto now = std::chrono::steady_clock::now();
+        std::vector<size_t> idle;
+        for (auto it = free_handles_.begin(); it != free_handles_.end();) {
+            if (now - handles_[*it].last_used >= keepalive_ping_) {
+                idle.push_back(*it);
+                it = free_handles_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (idle.empty()) {
+            continue;
+        }
+
+        lock.unlock();
+        for (size_t index : idle) {
+            std::string response;
+            perform(handles_[index], kPingBody, std::string(), response);
+        }
+        lock.lock();
+        free_handles_.insert(free_handles_.end(), idle.begin(), idle.end());
+        pool_cv_.notify_all();
+    }
+}
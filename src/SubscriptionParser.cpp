@@ -0,0 +1,255 @@
+// SubscriptionParser.cpp
+
+#include "SubscriptionParser.hpp"
+
+bool SubscriptionParser::parse(std::string_view payload, SubscriptionView& view) {
+    size_t pos = 0;
+    skip_whitespace(payload, pos);
+    if (pos >= payload.size() || payload[pos] != '{') {
+        return false;
+    }
+    ++pos;
+
+    bool is_subscription = false;
+    bool has_channel = false;
+    bool has_data = false;
+
+    while (true) {
+        skip_whitespace(payload, pos);
+        if (pos >= payload.size()) {
+            return false;
+        }
+        if (payload[pos] == '}') {
+            break;
+        }
+
+        std::string_view key;
+        if (!read_plain_string(payload, pos, key)) {
+            return false;
+        }
+        skip_whitespace(payload, pos);
+        if (pos >= payload.size() || payload[pos] != ':') {
+            return false;
+        }
+        ++pos;
+        skip_whitespace(payload, pos);
+
+        if (key == "method") {
+            std::string_view method;
+            if (!read_plain_string(payload, pos, method)) {
+                return false;
+            }
+            if (method != "subscription") {
+                // RPC results, heartbeats etc. take the slow path
+                return false;
+            }
+            is_subscription = true;
+        } else if (key == "params") {
+            if (!parse_params(payload, pos, view, has_channel, has_data)) {
+                return false;
+            }
+        } else if (!skip_value(payload, pos)) {
+            return false;
+        }
+
+        skip_whitespace(payload, pos);
+        if (pos >= payload.size()) {
+            return false;
+        }
+        if (payload[pos] == ',') {
+            ++pos;
+        } else if (payload[pos] != '}') {
+            return false;
+        }
+    }
+
+    return is_subscription && has_channel && has_data;
+}
+
+bool SubscriptionParser::is_response(std::string_view payload) {
+    size_t pos = 0;
+    skip_whitespace(payload, pos);
+    if (pos >= payload.size() || payload[pos] != '{') {
+        return false;
+    }
+    ++pos;
+
+    while (true) {
+        std::string_view key;
+        skip_whitespace(payload, pos);
+        if (!read_plain_string(payload, pos, key)) {
+            return false;
+        }
+        if (key == "id" || key == "result" || key == "error") {
+            return true;
+        }
+        if (key == "method") {
+            return false;
+        }
+
+        skip_whitespace(payload, pos);
+        if (pos >= payload.size() || payload[pos] != ':') {
+            return false;
+        }
+        ++pos;
+        skip_whitespace(payload, pos);
+        if (!skip_value(payload, pos)) {
+            return false;
+        }
+        skip_whitespace(payload, pos);
+        if (pos >= payload.size() || payload[pos] != ',') {
+            return false;
+        }
+        ++pos;
+    }
+}
+
+bool SubscriptionParser::parse_params(std::string_view payload, size_t& pos, SubscriptionView& view,
+                                      bool& has_channel, bool& has_data) {
+    if (pos >= payload.size() || payload[pos] != '{') {
+        return false;
+    }
+    ++pos;
+
+    while (true) {
+        skip_whitespace(payload, pos);
+        if (pos >= payload.size()) {
+            return false;
+        }
+        if (payload[pos] == '}') {
+            ++pos;
+            return true;
+        }
+
+        std::string_view key;
+        if (!read_plain_string(payload, pos, key)) {
+            return false;
+        }
+        skip_whitespace(payload, pos);
+        if (pos >= payload.size() || payload[pos] != ':') {
+            return false;
+        }
+        ++pos;
+        skip_whitespace(payload, pos);
+
+        if (key == "channel") {
+            if (!read_plain_string(payload, pos, view.channel)) {
+                return false;
+            }
+            has_channel = true;
+        } else if (key == "data") {
+            size_t start = pos;
+            if (!skip_value(payload, pos)) {
+                return false;
+            }
+            view.data = payload.substr(start, pos - start);
+            has_data = true;
+        } else if (!skip_value(payload, pos)) {
+            return false;
+        }
+
+        skip_whitespace(payload, pos);
+        if (pos >= payload.size()) {
+            return false;
+        }
+        if (payload[pos] == ',') {
+            ++pos;
+        } else if (payload[pos] != '}') {
+            return false;
+        }
+    }
+}
+
+void SubscriptionParser::skip_whitespace(std::string_view payload, size_t& pos) {
+    while (pos < payload.size()) {
+        char c = payload[pos];
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+            break;
+        }
+        ++pos;
+    }
+}
+
+// Read a string without escape sequences; the returned view excludes the quotes
+bool SubscriptionParser::read_plain_string(std::string_view payload, size_t& pos, std::string_view& out) {
+    if (pos >= payload.size() || payload[pos] != '"') {
+        return false;
+    }
+    size_t start = ++pos;
+    while (pos < payload.size()) {
+        char c = payload[pos];
+        if (c == '"') {
+            out = payload.substr(start, pos - start);
+            ++pos;
+            return true;
+        }
+        if (c == '\\') {
+            return false;
+        }
+        ++pos;
+    }
+    return false;
+}
+
+bool SubscriptionParser::skip_string(std::string_view payload, size_t& pos) {
+    // Assumes payload[pos] == '"'
+    ++pos;
+    while (pos < payload.size()) {
+        char c = payload[pos];
+        if (c == '\\') {
+            pos += 2;
+            continue;
+        }
+        ++pos;
+        if (c == '"') {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SubscriptionParser::skip_value(std::string_view payload, size_t& pos) {
+    if (pos >= payload.size()) {
+        return false;
+    }
+
+    char c = payload[pos];
+    if (c == '"') {
+        return skip_string(payload, pos);
+    }
+
+    if (c == '{' || c == '[') {
+        // Track nesting depth only; strings are skipped so brackets inside them are ignored
+        int depth = 0;
+        while (pos < payload.size()) {
+            c = payload[pos];
+            if (c == '"') {
+                if (!skip_string(payload, pos)) {
+                    return false;
+                }
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) {
+                    ++pos;
+                    return true;
+                }
+            }
+            ++pos;
+        }
+        return false;
+    }
+
+    // Number, true, false or null
+    size_t start = pos;
+    while (pos < payload.size()) {
+        c = payload[pos];
+        if (c == ',' || c == '}' || c == ']' || c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+            break;
+        }
+        ++pos;
+    }
+    return pos > start;
+}
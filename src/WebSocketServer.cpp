@@ -1,28 +1,65 @@
 // WebSocketServer.cpp
 
 #include "WebSocketServer.hpp"
+#include "BinaryEncoder.hpp"
 #include "Logger.hpp"
 #include <nlohmann/json.hpp> // Include JSON library
+#include <algorithm>
 #include <iostream>
 
 // For simplicity, using namespace for JSON
 using json = nlohmann::json;
 
-WebSocketServer::WebSocketServer(int port) : port_(port) {
+// How often held frames are retried against a slow client's send buffer
+static const long kFlushIntervalMs = 5;
+
+// Symbols a client may wait on before the gateway knows them
+static const size_t kMaxPendingSymbols = 256;
+
+WebSocketServer::WebSocketServer(int port, const WebSocketServerOptions& options)
+    : next_client_id_(1),
+      subscribers_(new std::atomic<std::shared_ptr<const SubscriberList>>[InstrumentRegistry::kMaxInstruments]),
+      port_(port), options_(options) {
+    options_.io_threads = std::max<size_t>(options_.io_threads, 1);
+    options_.send_queue_limit = std::max<size_t>(options_.send_queue_limit, 1);
     server_.init_asio();
     server_.set_open_handler(std::bind(&WebSocketServer::on_open, this, std::placeholders::_1));
     server_.set_close_handler(std::bind(&WebSocketServer::on_close, this, std::placeholders::_1));
     server_.set_message_handler(std::bind(&WebSocketServer::on_message, this, std::placeholders::_1, std::placeholders::_2));
+    InstrumentRegistry::getInstance().set_instrument_listener(
+        std::bind(&WebSocketServer::on_instrument_added, this, std::placeholders::_1));
+}
+
+WebSocketServer::~WebSocketServer() {
+    InstrumentRegistry::getInstance().set_instrument_listener(InstrumentRegistry::InstrumentListener());
 }
 
 void WebSocketServer::run() {
     try {
         server_.listen(port_);
         server_.start_accept();
-        Logger::getInstance().log("WebSocket Server started on port " + std::to_string(port_));
-        server_.run();
+        schedule_flush();
+        Logger::getInstance().log("WebSocket Server started on port " + std::to_string(port_) + " with " +
+                                  std::to_string(options_.io_threads) + " io thread(s)");
     } catch (const std::exception& e) {
         Logger::getInstance().log(std::string("WebSocket Server error: ") + e.what());
+        return;
+    }
+
+    auto run_io = [this]() {
+        try {
+            server_.run();
+        } catch (const std::exception& e) {
+            Logger::getInstance().log(std::string("WebSocket Server error: ") + e.what());
+        }
+    };
+    std::vector<std::thread> extra_threads;
+    for (size_t i = 1; i < options_.io_threads; ++i) {
+        extra_threads.emplace_back(run_io);
+    }
+    run_io();
+    for (auto& thread : extra_threads) {
+        thread.join();
     }
 }
 
@@ -31,36 +68,89 @@ void WebSocketServer::stop() {
 }
 
 void WebSocketServer::on_open(websocketpp::connection_hdl hdl) {
-    std::lock_guard<std::mutex> lock(connections_mtx_);
-    connections_.insert(hdl);
-    Logger::getInstance().log("Client connected.");
+    websocketpp::lib::error_code ec;
+    Server::connection_ptr connection = server_.get_con_from_hdl(hdl, ec);
+    if (ec) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(subscriptions_mtx_);
+    ClientId id = next_client_id_++;
+    client_ids_[hdl] = id;
+    auto state = std::make_shared<ClientState>(options_.send_queue_limit, options_.slow_consumer_policy);
+    state->id = id;
+    state->connection = connection;
+    // websocketpp only answers with the extension when it was negotiated
+    state->deflate = options_.permessage_deflate &&
+        connection->get_response_header("Sec-WebSocket-Extensions").find("permessage-deflate") != std::string::npos;
+    Logger::getInstance().log(std::string("Client connected") + (state->deflate ? " with permessage-deflate." : "."));
+    clients_[id].state = std::move(state);
 }
 
 void WebSocketServer::on_close(websocketpp::connection_hdl hdl) {
-    {
-        std::lock_guard<std::mutex> lock(connections_mtx_);
-        auto it = connections_.find(hdl);
-        if (it != connections_.end()) {
-            connections_.erase(it);
-        }
-    }
-    Logger::getInstance().log("Client disconnected.");
-
     // Remove client subscriptions
     std::lock_guard<std::mutex> lock_sub(subscriptions_mtx_);
-    auto it_sub = client_subscriptions_.find(hdl);
-    if (it_sub != client_subscriptions_.end()) {
-        std::lock_guard<std::mutex> lock_sym(symbol_mtx_);
-        for (const auto& symbol : it_sub->second) {
-            symbol_subscription_count_[symbol]--;
-            if (symbol_subscription_count_[symbol] == 0) {
+    ClientId client = find_client_locked(hdl);
+    auto it_sub = clients_.find(client);
+    if (it_sub == clients_.end()) {
+        Logger::getInstance().log("Client disconnected.");
+    } else {
+        {
+            // Broadcasts still holding the old subscriber lists skip it from here on
+            ClientState& state = *it_sub->second.state;
+            std::lock_guard<std::mutex> lock(state.mtx);
+            state.closing = true;
+            state.held.clear();
+            Logger::getInstance().log("Client disconnected (sent " + std::to_string(state.sent) + ", dropped " +
+                                      std::to_string(state.dropped) + ", conflated " +
+                                      std::to_string(state.conflated) + ").");
+        }
+        const InstrumentRegistry& registry = InstrumentRegistry::getInstance();
+        const auto& subscribed = it_sub->second.subscribed;
+        for (InstrumentId id = 0; id < subscribed.size(); ++id) {
+            if (!subscribed[id]) {
+                continue;
+            }
+            if (remove_subscriber_locked(id, client) == 0) {
                 // Unsubscribe from Deribit channel if no clients are subscribed
                 // Example: api.unsubscribe(symbol);
-                Logger::getInstance().log("No more subscriptions for symbol: " + symbol);
+                Logger::getInstance().log("No more subscriptions for symbol: " + registry.instrument_name(id));
             }
         }
-        client_subscriptions_.erase(it_sub);
+        clients_.erase(it_sub);
+    }
+    client_ids_.erase(hdl);
+}
+
+// 0 if the handle is not a known client; ids start at 1
+ClientId WebSocketServer::find_client_locked(websocketpp::connection_hdl hdl) const {
+    auto it = client_ids_.find(hdl);
+    return it == client_ids_.end() ? 0 : it->second;
+}
+
+size_t WebSocketServer::add_subscriber_locked(InstrumentId symbol, const std::shared_ptr<ClientState>& client) {
+    std::shared_ptr<const SubscriberList> current = subscribers_[symbol].load(std::memory_order_acquire);
+    auto updated = current ? std::make_shared<SubscriberList>(*current) : std::make_shared<SubscriberList>();
+    updated->push_back(client);
+    size_t count = updated->size();
+    subscribers_[symbol].store(std::move(updated), std::memory_order_release);
+    return count;
+}
+
+size_t WebSocketServer::remove_subscriber_locked(InstrumentId symbol, ClientId id) {
+    std::shared_ptr<const SubscriberList> current = subscribers_[symbol].load(std::memory_order_acquire);
+    if (!current) {
+        return 0;
+    }
+    auto updated = std::make_shared<SubscriberList>();
+    updated->reserve(current->size());
+    for (const auto& subscriber : *current) {
+        if (subscriber->id != id) {
+            updated->push_back(subscriber);
+        }
     }
+    size_t count = updated->size();
+    subscribers_[symbol].store(std::move(updated), std::memory_order_release);
+    return count;
 }
 
 void WebSocketServer::on_message(websocketpp::connection_hdl hdl, Server::message_ptr msg) {
@@ -112,31 +202,120 @@ void WebSocketServer::handle_subscribe(websocketpp::connection_hdl hdl, const js
         return;
     }
 
+    // Applies to everything the client receives, not just these symbols
+    std::string encoding = payload.value("encoding", std::string());
+    if (!encoding.empty() && encoding != "json" && encoding != "binary") {
+        json error_response = {
+            {"error", "Unknown encoding. Use 'json' or 'binary'."}
+        };
+        server_.send(hdl, error_response.dump(), websocketpp::frame::opcode::text);
+        return;
+    }
+
     std::vector<std::string> symbols = payload["symbols"].get<std::vector<std::string>>();
+    std::vector<std::string> accepted;
+    std::vector<std::string> rejected;
+    json instrument_ids = json::object();
+    bool binary = false;
     {
         std::lock_guard<std::mutex> lock(subscriptions_mtx_);
+        ClientId client = find_client_locked(hdl);
+        auto it = clients_.find(client);
+        if (it != clients_.end()) {
+            std::lock_guard<std::mutex> state_lock(it->second.state->mtx);
+            if (!encoding.empty()) {
+                it->second.state->binary = encoding == "binary";
+            }
+            binary = it->second.state->binary;
+        }
         for (const auto& symbol : symbols) {
-            client_subscriptions_[hdl].insert(symbol);
-            {
-                std::lock_guard<std::mutex> lock_sym(symbol_mtx_);
-                symbol_subscription_count_[symbol]++;
-                if (symbol_subscription_count_[symbol] == 1) {
-                    // Subscribe to Deribit channel if this is the first subscription
-                    // Example: api.subscribe(symbol);
-                    Logger::getInstance().log("Subscribed to Deribit channel for symbol: " + symbol);
-                }
+            if (it == clients_.end()) {
+                break;
+            }
+            // Client strings are never interned, so no client can fill the registry
+            InstrumentId id = InstrumentRegistry::getInstance().find_instrument(symbol);
+            if (id != kInvalidId) {
+                accepted.push_back(symbol);
+                instrument_ids[symbol] = id;
+                attach_locked(it->second, id);
+                continue;
+            }
+            // Not known yet: the upstream feed may be started later, so wait for the
+            // registry to intern it, up to a per-client limit
+            auto& pending = it->second.pending;
+            if (pending.size() < kMaxPendingSymbols || pending.count(symbol)) {
+                pending.insert(symbol);
+                accepted.push_back(symbol);
+            } else {
+                rejected.push_back(symbol);
             }
         }
     }
 
-    // Acknowledge subscription
+    // Acknowledge subscription; binary messages identify instruments by these ids
     json success_response = {
-        {"result", symbols},
-        {"action", "subscribe"}
+        {"result", accepted},
+        {"action", "subscribe"},
+        {"encoding", binary ? "binary" : "json"}
     };
+    if (!rejected.empty()) {
+        success_response["rejected"] = rejected;
+    }
+    if (binary) {
+        success_response["instrument_ids"] = instrument_ids;
+    }
     server_.send(hdl, success_response.dump(), websocketpp::frame::opcode::text);
 }
 
+// Adds the client to an instrument's subscriber list unless it is already on it
+void WebSocketServer::attach_locked(Client& client, InstrumentId id) {
+    auto& subscribed = client.subscribed;
+    if (subscribed.size() <= id) {
+        subscribed.resize(id + 1, false);
+    }
+    if (subscribed[id]) {
+        return;
+    }
+    subscribed[id] = true;
+    if (add_subscriber_locked(id, client.state) == 1) {
+        // Subscribe to Deribit channel if this is the first subscription
+        // Example: api.subscribe(symbol);
+        Logger::getInstance().log("Subscribed to Deribit channel for symbol: " +
+                                  InstrumentRegistry::getInstance().instrument_name(id));
+    }
+}
+
+// Registry listener: clients that subscribed to the instrument before it was
+// known are attached now and told its id
+void WebSocketServer::on_instrument_added(InstrumentId id) {
+    const std::string& symbol = InstrumentRegistry::getInstance().instrument_name(id);
+    std::vector<std::pair<Server::connection_ptr, bool>> waiting;
+    {
+        std::lock_guard<std::mutex> lock(subscriptions_mtx_);
+        for (auto& entry : clients_) {
+            Client& client = entry.second;
+            if (client.pending.erase(symbol) == 0) {
+                continue;
+            }
+            attach_locked(client, id);
+            std::lock_guard<std::mutex> state_lock(client.state->mtx);
+            waiting.emplace_back(client.state->connection, client.state->binary);
+        }
+    }
+
+    for (const auto& client : waiting) {
+        json response = {
+            {"result", {symbol}},
+            {"action", "subscribe"},
+            {"encoding", client.second ? "binary" : "json"}
+        };
+        if (client.second) {
+            response["instrument_ids"] = {{symbol, id}};
+        }
+        client.first->send(response.dump(), websocketpp::frame::opcode::text);
+    }
+}
+
 void WebSocketServer::handle_unsubscribe(websocketpp::connection_hdl hdl, const json& payload) {
     if (!payload.contains("symbols") || !payload["symbols"].is_array()) {
         json error_response = {
@@ -149,19 +328,19 @@ void WebSocketServer::handle_unsubscribe(websocketpp::connection_hdl hdl, const
     std::vector<std::string> symbols = payload["symbols"].get<std::vector<std::string>>();
     {
         std::lock_guard<std::mutex> lock(subscriptions_mtx_);
+        ClientId client = find_client_locked(hdl);
+        auto it = clients_.find(client);
         for (const auto& symbol : symbols) {
-            auto it = client_subscriptions_.find(hdl);
-            if (it != client_subscriptions_.end()) {
-                it->second.erase(symbol);
-                {
-                    std::lock_guard<std::mutex> lock_sym(symbol_mtx_);
-                    symbol_subscription_count_[symbol]--;
-                    if (symbol_subscription_count_[symbol] == 0) {
-                        // Unsubscribe from Deribit channel if no clients are subscribed
-                        // Example: api.unsubscribe(symbol);
-                        Logger::getInstance().log("Unsubscribed from Deribit channel for symbol: " + symbol);
-                        symbol_subscription_count_.erase(symbol);
-                    }
+            if (it != clients_.end()) {
+                it->second.pending.erase(symbol);
+            }
+            InstrumentId id = InstrumentRegistry::getInstance().find_instrument(symbol);
+            if (it != clients_.end() && id != kInvalidId && id < it->second.subscribed.size() && it->second.subscribed[id]) {
+                it->second.subscribed[id] = false;
+                if (remove_subscriber_locked(id, client) == 0) {
+                    // Unsubscribe from Deribit channel if no clients are subscribed
+                    // Example: api.unsubscribe(symbol);
+                    Logger::getInstance().log("Unsubscribed from Deribit channel for symbol: " + symbol);
                 }
             }
         }
@@ -175,16 +354,174 @@ void WebSocketServer::handle_unsubscribe(websocketpp::connection_hdl hdl, const
     server_.send(hdl, success_response.dump(), websocketpp::frame::opcode::text);
 }
 
-void WebSocketServer::broadcast(const std::string& symbol, const std::string& message) {
-    std::lock_guard<std::mutex> lock(connections_mtx_);
-    std::lock_guard<std::mutex> lock_sub(subscriptions_mtx_);
+// A complete, already framed message. Server frames are never masked, so the
+// header and payload are the same for every connection; websocketpp queues a
+// prepared message as is instead of copying it into a per-connection frame.
+Server::message_ptr WebSocketServer::make_frame(std::string_view payload, websocketpp::frame::opcode::value opcode) {
+    typedef ServerConfig::message_type message_type;
+    auto frame = std::make_shared<message_type>(message_type::con_msg_man_ptr(), opcode, payload.size());
+    frame->set_payload(payload.data(), payload.size());
+    websocketpp::frame::basic_header header(opcode, payload.size(), true, false);
+    websocketpp::frame::extended_header extended(payload.size());
+    frame->set_header(websocketpp::frame::prepare_header(header, extended));
+    frame->set_prepared(true);
+    return frame;
+}
+
+// An unprepared message is framed by each connection, which is where
+// permessage-deflate compresses it
+Server::message_ptr WebSocketServer::make_compressible(std::string_view payload) {
+    typedef ServerConfig::message_type message_type;
+    auto message = std::make_shared<message_type>(message_type::con_msg_man_ptr(), websocketpp::frame::opcode::text,
+                                                  payload.size());
+    message->set_payload(payload.data(), payload.size());
+    message->set_compressed(true);
+    return message;
+}
 
-    for(auto it : connections_) {
-        auto it_sub = client_subscriptions_.find(it);
-        if (it_sub != client_subscriptions_.end()) {
-            if (it_sub->second.find(symbol) != it_sub->second.end()) {
-                server_.send(it, message, websocketpp::frame::opcode::text);
+// Channels without a binary form go to binary clients as JSON text
+const Server::message_ptr& WebSocketServer::frame_for(Frames& frames, const ClientState& client) {
+    if (client.binary) {
+        if (!frames.binary_tried) {
+            frames.binary_tried = true;
+            std::string_view encoded = BinaryEncoder::encode(frames.type, frames.symbol, frames.message);
+            if (!encoded.empty()) {
+                frames.binary = make_frame(encoded, websocketpp::frame::opcode::binary);
             }
         }
+        if (frames.binary) {
+            return frames.binary;
+        }
+    } else if (client.deflate) {
+        if (!frames.deflate) {
+            frames.deflate = make_compressible(frames.message);
+        }
+        return frames.deflate;
+    }
+    if (!frames.text) {
+        frames.text = make_frame(frames.message, websocketpp::frame::opcode::text);
+    }
+    return frames.text;
+}
+
+// Walks only the symbol's own subscribers, from a snapshot taken without locking
+void WebSocketServer::broadcast(ChannelId channel, std::string_view message) {
+    const InstrumentRegistry& registry = InstrumentRegistry::getInstance();
+    InstrumentId symbol = registry.channel_instrument(channel);
+    if (symbol >= InstrumentRegistry::kMaxInstruments) {
+        return;
+    }
+    std::shared_ptr<const SubscriberList> subscribers = subscribers_[symbol].load(std::memory_order_acquire);
+    if (!subscribers || subscribers->empty()) {
+        return;
+    }
+
+    Frames frames;
+    frames.channel = channel;
+    frames.type = registry.channel_type(channel);
+    frames.symbol = symbol;
+    frames.message = message;
+    for (const auto& subscriber : *subscribers) {
+        std::lock_guard<std::mutex> lock(subscriber->mtx);
+        if (subscriber->closing) {
+            continue;
+        }
+        const Server::message_ptr& frame = frame_for(frames, *subscriber);
+        // Anything already held goes first, so a client never sees messages out of order
+        if (subscriber->held.empty() &&
+            subscriber->connection->get_buffered_amount() < options_.send_high_water_bytes) {
+            subscriber->connection->send(frame);
+            ++subscriber->sent;
+        } else {
+            hold_locked(subscriber, frames, frame);
+        }
+    }
+}
+
+// Queue a frame the client is not ready for; what happens when the queue is
+// full depends on the slow consumer policy
+void WebSocketServer::hold_locked(const std::shared_ptr<ClientState>& client, const Frames& frames,
+                                  const Server::message_ptr& frame) {
+    ClientState& state = *client;
+    switch (state.held.push(frames.channel, is_snapshot_channel(frames.type), frame)) {
+    case HeldQueue<Server::message_ptr>::Result::Queued:
+        break;
+    case HeldQueue<Server::message_ptr>::Result::Conflated:
+        ++state.conflated;
+        return;
+    case HeldQueue<Server::message_ptr>::Result::DroppedOldest:
+        if (state.dropped == 0) {
+            Logger::getInstance().log("Client " + std::to_string(state.id) +
+                                      " is too slow; dropping its oldest messages.");
+        }
+        ++state.dropped;
+        break;
+    case HeldQueue<Server::message_ptr>::Result::Overflow: {
+        state.dropped += state.held.size() + 1;
+        state.held.clear();
+        state.closing = true;
+        Logger::getInstance().log("Client " + std::to_string(state.id) + " is too slow; disconnecting with " +
+                                  std::to_string(state.connection->get_buffered_amount()) + " bytes unsent.");
+        websocketpp::lib::error_code ec;
+        state.connection->close(websocketpp::close::status::policy_violation, "slow consumer", ec);
+        return;
+    }
+    }
+
+    if (!state.backlogged) {
+        state.backlogged = true;
+        std::lock_guard<std::mutex> lock(backlog_mtx_);
+        backlogged_.push_back(client);
+    }
+}
+
+void WebSocketServer::drain_locked(ClientState& client) {
+    while (!client.held.empty() && !client.closing &&
+           client.connection->get_buffered_amount() < options_.send_high_water_bytes) {
+        client.connection->send(client.held.front());
+        ++client.sent;
+        client.held.pop_front();
+    }
+}
+
+void WebSocketServer::schedule_flush() {
+    server_.set_timer(kFlushIntervalMs, [this](const websocketpp::lib::error_code& ec) {
+        if (ec) {
+            return;
+        }
+        flush_backlogged();
+        schedule_flush();
+    });
+}
+
+void WebSocketServer::flush_backlogged() {
+    std::vector<std::shared_ptr<ClientState>> clients;
+    {
+        std::lock_guard<std::mutex> lock(backlog_mtx_);
+        clients.swap(backlogged_);
+    }
+    for (const auto& client : clients) {
+        std::lock_guard<std::mutex> lock(client->mtx);
+        drain_locked(*client);
+        if (client->held.empty() || client->closing) {
+            client->backlogged = false;
+        } else {
+            std::lock_guard<std::mutex> backlog_lock(backlog_mtx_);
+            backlogged_.push_back(client);
+        }
+    }
+}
+
+std::vector<ClientStats> WebSocketServer::get_client_stats() {
+    std::vector<ClientStats> stats;
+    std::lock_guard<std::mutex> lock(subscriptions_mtx_);
+    stats.reserve(clients_.size());
+    for (const auto& entry : clients_) {
+        ClientState& state = *entry.second.state;
+        std::lock_guard<std::mutex> state_lock(state.mtx);
+        stats.push_back(ClientStats{state.id, state.held.size(), state.connection->get_buffered_amount(),
+                                    state.sent, state.dropped, state.conflated, state.binary, state.deflate});
     }
+    std::sort(stats.begin(), stats.end(), [](const ClientStats& a, const ClientStats& b) { return a.id < b.id; });
+    return stats;
 }
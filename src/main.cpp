@@ -3,10 +3,14 @@
 #include "Config.hpp"
 #include "DeribitAPI.hpp"
 #include "OrderManager.hpp"
+#include "OrderBookManager.hpp"
+#include "PositionCache.hpp"
 #include "WebSocketServer.hpp"
 #include "Logger.hpp"
 #include <thread>
 #include <algorithm>
+#include <chrono>
+#include <future>
 
 int main() {
     try {
@@ -17,7 +21,30 @@ int main() {
         Logger::getInstance().log("Starting DeribitTrader...");
 
         // Initialize Deribit API
-        DeribitAPI api(config.api_key, config.api_secret, config.rest_url, config.websocket_url);
+        DeribitOptions api_options;
+        api_options.market_data_queue_capacity = config.market_data_queue_capacity;
+        api_options.market_data_conflation = config.market_data_conflation;
+        api_options.market_data_workers = config.market_data_workers;
+        api_options.ws_connections = config.ws_connections;
+        api_options.shard_policy = config.ws_shard_policy == "explicit"
+            ? ShardPolicy::Explicit : ShardPolicy::Hash;
+        api_options.shard_assignments = config.ws_shard_assignments;
+        api_options.heartbeat_interval_s = config.ws_heartbeat_interval;
+        api_options.idle_probe_ms = config.ws_idle_probe_ms;
+        api_options.idle_timeout_ms = config.ws_idle_timeout_ms;
+        api_options.reconnect_min_ms = config.ws_reconnect_min_ms;
+        api_options.reconnect_max_ms = config.ws_reconnect_max_ms;
+        api_options.request_timeout_ms = config.ws_request_timeout_ms;
+        api_options.rest_connections = config.rest_connections;
+        api_options.rest_keepalive_ping_ms = config.rest_keepalive_ping_ms;
+        api_options.rest_async_max_connections = config.rest_async_max_connections;
+        api_options.matching_engine_rate = config.rate_limit_matching_per_s;
+        api_options.matching_engine_burst = config.rate_limit_matching_burst;
+        api_options.non_matching_rate = config.rate_limit_non_matching_per_s;
+        api_options.non_matching_burst = config.rate_limit_non_matching_burst;
+        api_options.cancel_reserve = config.rate_limit_cancel_reserve;
+        api_options.rate_limit_max_queue_ms = config.rate_limit_max_queue_ms;
+        DeribitAPI api(config.api_key, config.api_secret, config.rest_url, config.websocket_url, api_options);
 
         // Authenticate
         if (!api.authenticate()) {
@@ -26,28 +53,36 @@ int main() {
         }
 
         // Initialize Order Manager
-        OrderManager order_manager(api);
+        // Positions stream from user.changes; REST only seeds and checks them
+        PositionCache positions(api, config.position_reconcile_interval_s);
+
+        OrderManager order_manager(api, positions, config.order_journal_file, config.order_journal_capacity);
+
+        // Local order books maintained from incremental book channels
+        OrderBookManager order_books(api);
 
         // Initialize WebSocket Server
-        WebSocketServer ws_server(config.websocket_port);
+        WebSocketServerOptions ws_options;
+        ws_options.io_threads = config.websocket_io_threads;
+        ws_options.send_high_water_bytes = config.websocket_send_high_water_bytes;
+        ws_options.send_queue_limit = config.websocket_send_queue_limit;
+        ws_options.slow_consumer_policy = config.websocket_slow_consumer_policy == "conflate"
+            ? SlowConsumerPolicy::Conflate
+            : config.websocket_slow_consumer_policy == "disconnect"
+                ? SlowConsumerPolicy::Disconnect : SlowConsumerPolicy::DropOldest;
+        ws_options.permessage_deflate = config.websocket_permessage_deflate;
+        WebSocketServer ws_server(config.websocket_port, ws_options);
         std::thread ws_thread([&ws_server]() {
             ws_server.run();
         });
 
         // Set up the callback to broadcast incoming market data to WebSocket clients
-        api.set_message_callback([&ws_server](const std::string& channel, const std::string& message) {
-            // Extract the symbol from the channel name
-            std::string symbol;
-            size_t first_dot = channel.find('.');
-            size_t second_dot = channel.find('.', first_dot + 1);
-            if (first_dot != std::string::npos && second_dot != std::string::npos) {
-                symbol = channel.substr(first_dot + 1, second_dot - first_dot - 1);
-            } else {
-                symbol = "unknown";
-            }
+        api.set_message_callback([&ws_server, &order_books](ChannelId channel, std::string_view message) {
+            // Keep the local book current before fanning the update out
+            order_books.on_book_update(channel, message);
 
-            // Broadcast the message to subscribed WebSocket clients
-            ws_server.broadcast(symbol, message);
+            // Broadcast the message to clients subscribed to the channel's symbol
+            ws_server.broadcast(channel, message);
         });
 
         // CLI Loop
@@ -61,7 +96,8 @@ int main() {
                       << "view_positions: 5\n"
                       << "subscribe: 6\n"
                       << "unsubscribe: 7\n"
-                      << "exit: 8\n"
+                      << "client_stats: 8\n"
+                      << "exit: 9\n"
                       << "Enter Command: ";
             std::getline(std::cin, command);
 
@@ -120,6 +156,23 @@ int main() {
                 std::string instrument;
                 std::cout << "Enter Instrument (e.g., ETH-PERPETUAL): ";
                 std::getline(std::cin, instrument);
+
+                // Serve from the local book when we are subscribed to its book channel
+                std::vector<PriceLevel> bids, asks;
+                if (order_books.get_depth(instrument, 10, bids, asks)) {
+                    std::cout << "Order Book for " << instrument << " (local):\n";
+                    std::cout << "Asks:\n";
+                    for (auto it = asks.rbegin(); it != asks.rend(); ++it) {
+                        std::cout << "  " << it->price << " x " << it->amount << "\n";
+                    }
+                    std::cout << "Bids:\n";
+                    for (const auto& level : bids) {
+                        std::cout << "  " << level.price << " x " << level.amount << "\n";
+                    }
+                    std::cout << std::flush;
+                    continue;
+                }
+
                 nlohmann::json orderbook = api.get_orderbook(instrument);
                 if (orderbook.contains("result")) {
                     std::cout << "Order Book for " << instrument << ":\n" << orderbook.dump(4) << std::endl;
@@ -128,11 +181,17 @@ int main() {
                 }
             }
             else if (command == "5") {
-                nlohmann::json positions = api.get_positions();
-                if (positions.contains("result")) {
-                    std::cout << "Current Positions:\n" << positions.dump(4) << std::endl;
+                std::vector<Position> open_positions = positions.get_positions();
+                if (open_positions.empty()) {
+                    std::cout << "No open positions." << std::endl;
                 } else {
-                    std::cout << "Failed to fetch positions. Check logs for details." << std::endl;
+                    std::cout << "Current Positions:\n";
+                    for (const auto& position : open_positions) {
+                        std::cout << position.instrument << ": size " << position.size
+                                  << ", average price " << position.average_price
+                                  << ", mark price " << position.mark_price
+                                  << ", floating PnL " << position.floating_pnl << std::endl;
+                    }
                 }
             }
             else if (command == "6") {
@@ -148,15 +207,26 @@ int main() {
                 }
                 symbols.push_back(symbols_input); // Add the last symbol
 
+                std::vector<std::string> channels;
                 for(auto &symbol : symbols) {
                     // Trim whitespace
                     symbol.erase(symbol.find_last_not_of(" \n\r\t")+1);
                     symbol.erase(0, symbol.find_first_not_of(" \n\r\t"));
-                    if(api.subscribe(symbol + ".100ms")) { // Example channel format
-                        std::cout << "Subscribed to symbol: " << symbol << std::endl;
+                    channels.push_back(symbol + ".100ms"); // Example channel format
+                }
+
+                // Send all channels in one request and report what the exchange accepted
+                auto result = api.subscribe(channels);
+                std::vector<std::string> accepted;
+                if (result.wait_for(std::chrono::seconds(5)) == std::future_status::ready) {
+                    accepted = result.get();
+                }
+                for (size_t i = 0; i < symbols.size(); ++i) {
+                    if (std::find(accepted.begin(), accepted.end(), channels[i]) != accepted.end()) {
+                        std::cout << "Subscribed to symbol: " << symbols[i] << std::endl;
                     }
                     else {
-                        std::cout << "Failed to subscribe to symbol: " << symbol << std::endl;
+                        std::cout << "Failed to subscribe to symbol: " << symbols[i] << std::endl;
                     }
                 }
             }
@@ -173,19 +243,42 @@ int main() {
                 }
                 symbols.push_back(symbols_input); // Add the last symbol
 
+                std::vector<std::string> channels;
                 for(auto &symbol : symbols) {
                     // Trim whitespace
                     symbol.erase(symbol.find_last_not_of(" \n\r\t")+1);
                     symbol.erase(0, symbol.find_first_not_of(" \n\r\t"));
-                    if(api.unsubscribe(symbol + ".100ms")) { // Example channel format
-                        std::cout << "Unsubscribed from symbol: " << symbol << std::endl;
+                    channels.push_back(symbol + ".100ms"); // Example channel format
+                }
+
+                // Send all channels in one request and report what the exchange accepted
+                auto result = api.unsubscribe(channels);
+                std::vector<std::string> accepted;
+                if (result.wait_for(std::chrono::seconds(5)) == std::future_status::ready) {
+                    accepted = result.get();
+                }
+                for (size_t i = 0; i < symbols.size(); ++i) {
+                    if (std::find(accepted.begin(), accepted.end(), channels[i]) != accepted.end()) {
+                        std::cout << "Unsubscribed from symbol: " << symbols[i] << std::endl;
                     }
                     else {
-                        std::cout << "Failed to unsubscribe from symbol: " << symbol << std::endl;
+                        std::cout << "Failed to unsubscribe from symbol: " << symbols[i] << std::endl;
                     }
                 }
             }
             else if (command == "8") {
+                std::vector<ClientStats> clients = ws_server.get_client_stats();
+                if (clients.empty()) {
+                    std::cout << "No clients connected." << std::endl;
+                }
+                for (const auto& client : clients) {
+                    std::cout << "Client " << client.id << " (" << (client.binary ? "binary" : "json")
+                              << (client.deflate ? ", deflate" : "") << "): " << client.queue_depth << " held, "
+                              << client.buffered_bytes << " bytes buffered, " << client.sent << " sent, "
+                              << client.dropped << " dropped, " << client.conflated << " conflated" << std::endl;
+                }
+            }
+            else if (command == "9") {
                 std::cout << "Exiting application..." << std::endl;
                 return 0;
             }
@@ -0,0 +1,140 @@
+// BinaryEncoderTest.cpp
+
+#include "BinaryEncoder.hpp"
+#include "BookDecoder.hpp"
+#include "Check.hpp"
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+typedef BinaryEncoder::Header Header;
+
+static const InstrumentId kInstrument = 7;
+
+template <typename T>
+static T record_at(std::string_view message, size_t offset) {
+    T record;
+    std::memcpy(&record, message.data() + offset, sizeof(T));
+    return record;
+}
+
+static bool check_header(std::string_view message, uint8_t type, uint8_t flags, uint32_t count, size_t record_size) {
+    if (message.size() < sizeof(Header)) {
+        return false;
+    }
+    auto header = record_at<Header>(message, 0);
+    size_t body = type == BinaryEncoder::Book ? sizeof(BinaryEncoder::BookHeader) : 0;
+    return header.type == type && header.flags == flags && header.instrument == kInstrument && header.count == count &&
+           header.reserved == 0 && header.reserved2 == 0 && message.size() == sizeof(Header) + body + count * record_size;
+}
+
+static BinaryEncoder::BookLevel level_at(std::string_view message, size_t index) {
+    return record_at<BinaryEncoder::BookLevel>(message, sizeof(Header) + sizeof(BinaryEncoder::BookHeader) +
+                                                            index * sizeof(BinaryEncoder::BookLevel));
+}
+
+static bool check_level(const BinaryEncoder::BookLevel& level, uint8_t side, uint8_t action, double price, double amount) {
+    static const uint8_t kZero[sizeof(level.padding)] = {};
+    return level.side == side && level.action == action && level.price == price && level.amount == amount &&
+           std::memcmp(level.padding, kZero, sizeof(kZero)) == 0;
+}
+
+static void test_book_snapshot() {
+    std::string_view message = BinaryEncoder::encode(ChannelType::Book, kInstrument,
+        R"({"type":"snapshot","timestamp":1700000000000,"instrument_name":"BTC-PERPETUAL","change_id":100,)"
+        R"("bids":[["new",65000.5,10.0],["new",64999.0,2.5]],"asks":[["new",65001.0,7.0]]})");
+    CHECK(check_header(message, BinaryEncoder::Book, BinaryEncoder::Snapshot, 3, sizeof(BinaryEncoder::BookLevel)));
+    auto book = record_at<BinaryEncoder::BookHeader>(message, sizeof(Header));
+    CHECK(book.change_id == 100);
+    CHECK(book.prev_change_id == 0);
+    CHECK(check_level(level_at(message, 0), 0, 0, 65000.5, 10.0));
+    CHECK(check_level(level_at(message, 1), 0, 0, 64999.0, 2.5));
+    CHECK(check_level(level_at(message, 2), 1, 0, 65001.0, 7.0));
+}
+
+static void test_book_increment() {
+    std::string_view message = BinaryEncoder::encode(ChannelType::Book, kInstrument,
+        R"({"type":"change","timestamp":1700000000100,"instrument_name":"BTC-PERPETUAL","prev_change_id":100,)"
+        R"("change_id":101,"bids":[["delete",64999.0,0.0]],"asks":[["change",65001.0,3.0],["new",65002.5,1.0]]})");
+    CHECK(check_header(message, BinaryEncoder::Book, 0, 3, sizeof(BinaryEncoder::BookLevel)));
+    auto book = record_at<BinaryEncoder::BookHeader>(message, sizeof(Header));
+    CHECK(book.change_id == 101);
+    CHECK(book.prev_change_id == 100);
+    CHECK(check_level(level_at(message, 0), 0, 2, 64999.0, 0.0));
+    CHECK(check_level(level_at(message, 1), 1, 1, 65001.0, 3.0));
+    CHECK(check_level(level_at(message, 2), 1, 0, 65002.5, 1.0));
+}
+
+static void test_book_generic_fallback() {
+    // An escaped string is beyond the streaming decoder; the result must still be binary
+    const std::string payload = R"({"type":"chang\u0065","instrument_name":"BTC-PERPETUAL","prev_change_id":101,)"
+                                R"("change_id":102,"bids":[["new",64998.0,4.0]],"asks":[]})";
+    BookUpdate update;
+    CHECK(!BookDecoder::decode_book(payload, update));
+    std::string_view message = BinaryEncoder::encode(ChannelType::Book, kInstrument, payload);
+    CHECK(check_header(message, BinaryEncoder::Book, 0, 1, sizeof(BinaryEncoder::BookLevel)));
+    auto book = record_at<BinaryEncoder::BookHeader>(message, sizeof(Header));
+    CHECK(book.change_id == 102);
+    CHECK(book.prev_change_id == 101);
+    CHECK(check_level(level_at(message, 0), 0, 0, 64998.0, 4.0));
+
+    CHECK(BinaryEncoder::encode(ChannelType::Book, kInstrument, R"({"bids":[)").empty());
+}
+
+static void test_trades() {
+    std::string_view message = BinaryEncoder::encode(ChannelType::Trades, kInstrument,
+        R"([{"trade_seq":501,"trade_id":"1","timestamp":1700000000200,"tick_direction":0,"price":65000.5,)"
+        R"("instrument_name":"BTC-PERPETUAL","index_price":64990.1,"direction":"buy","amount":20.0},)"
+        R"({"trade_seq":502,"trade_id":"2","timestamp":1700000000300,"tick_direction":2,"price":64999.5,)"
+        R"("instrument_name":"BTC-PERPETUAL","index_price":64990.1,"direction":"sell","amount":0.5}])");
+    CHECK(check_header(message, BinaryEncoder::Trades, 0, 2, sizeof(BinaryEncoder::TradeRecord)));
+    auto first = record_at<BinaryEncoder::TradeRecord>(message, sizeof(Header));
+    auto second = record_at<BinaryEncoder::TradeRecord>(message, sizeof(Header) + sizeof(BinaryEncoder::TradeRecord));
+    CHECK(first.trade_seq == 501 && first.timestamp_ms == 1700000000200ull);
+    CHECK(first.price == 65000.5 && first.amount == 20.0 && first.is_buy == 1);
+    CHECK(second.trade_seq == 502 && second.timestamp_ms == 1700000000300ull);
+    CHECK(second.price == 64999.5 && second.amount == 0.5 && second.is_buy == 0);
+}
+
+static void test_ticker_and_quote() {
+    // last_price is null before the first trade
+    std::string_view message = BinaryEncoder::encode(ChannelType::Ticker, kInstrument,
+        R"({"timestamp":1700000000400,"instrument_name":"BTC-PERPETUAL","best_bid_price":65000.0,)"
+        R"("best_bid_amount":12.0,"best_ask_price":65000.5,"best_ask_amount":3.0,"last_price":null,)"
+        R"("mark_price":65000.2,"index_price":64990.1,"state":"open"})");
+    CHECK(check_header(message, BinaryEncoder::Ticker, 0, 1, sizeof(BinaryEncoder::TickerRecord)));
+    auto ticker = record_at<BinaryEncoder::TickerRecord>(message, sizeof(Header));
+    CHECK(ticker.timestamp_ms == 1700000000400ull);
+    CHECK(ticker.best_bid_price == 65000.0 && ticker.best_bid_amount == 12.0);
+    CHECK(ticker.best_ask_price == 65000.5 && ticker.best_ask_amount == 3.0);
+    CHECK(std::isnan(ticker.last_price));
+    CHECK(ticker.mark_price == 65000.2 && ticker.index_price == 64990.1);
+
+    // Quotes carry only the top of book
+    message = BinaryEncoder::encode(ChannelType::Quote, kInstrument,
+        R"({"timestamp":1700000000500,"instrument_name":"BTC-PERPETUAL","best_bid_price":65000.0,)"
+        R"("best_bid_amount":11.0,"best_ask_price":65000.5,"best_ask_amount":4.0})");
+    CHECK(check_header(message, BinaryEncoder::Ticker, 0, 1, sizeof(BinaryEncoder::TickerRecord)));
+    auto quote = record_at<BinaryEncoder::TickerRecord>(message, sizeof(Header));
+    CHECK(quote.timestamp_ms == 1700000000500ull);
+    CHECK(quote.best_bid_amount == 11.0 && quote.best_ask_amount == 4.0);
+    CHECK(std::isnan(quote.last_price) && std::isnan(quote.mark_price) && std::isnan(quote.index_price));
+}
+
+static void test_no_binary_form() {
+    CHECK(BinaryEncoder::encode(ChannelType::BookSnapshot, kInstrument, R"({"bids":[],"asks":[]})").empty());
+    CHECK(BinaryEncoder::encode(ChannelType::User, kInstrument, R"({"order_id":"1"})").empty());
+    CHECK(BinaryEncoder::encode(ChannelType::Ticker, kInstrument, "[1,2]").empty());
+}
+
+int main() {
+    test_book_snapshot();
+    test_book_increment();
+    test_book_generic_fallback();
+    test_trades();
+    test_ticker_and_quote();
+    test_no_binary_form();
+
+    return check_failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+// BookDecoderTest.cpp
+
+#include "BookDecoder.hpp"
+#include "Check.hpp"
+#include <bit>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <nlohmann/json.hpp>
+
+// Numbers whose conversion the fast path, the from_chars fallback or the
+// integer/float split in nlohmann could get wrong
+static const char* const kNumbers[] = {
+    // Integers without a fraction, which nlohmann reads through int64/uint64
+    "0", "-0", "1", "-1", "100", "65000", "9007199254740992", "9007199254740993",
+    "9223372036854775807", "-9223372036854775808", "18446744073709551615", "123456789012345678901234567890",
+    // Fractions, including trailing zeros and negative zero
+    "0.0", "-0.0", "1.0", "10.000", "0.1", "0.3", "65000.5", "-2.25", "0.000001", "1234.5678",
+    // Exponents
+    "1e5", "1E5", "1e+5", "1e-5", "123e-2", "1.5e+10", "-2.5e-3", "1e22", "1e23", "1e-22", "1e-23",
+    "4.35e15", "0e10", "-0e-5",
+    // More than 15 significant digits
+    "12345.678901234567", "0.1234567890123456789", "1234567890123456.7", "3.141592653589793238",
+    "9007199254740993.0", "0.30000000000000004",
+    // Subnormals and the edges of the range
+    "5e-324", "4.9e-324", "-4.9e-324", "1e-310", "2.2250738585072009e-308", "2.2250738585072014e-308",
+    "1.7976931348623157e308",
+};
+
+static uint64_t bits(double value) {
+    return std::bit_cast<uint64_t>(value);
+}
+
+// What the generic path stores: nlohmann's parse, read back with get<double>()
+static double nlohmann_value(const std::string& number) {
+    return nlohmann::json::parse(number).get<double>();
+}
+
+static void check_book(const std::string& number) {
+    std::string payload = "{\"type\":\"change\",\"change_id\":2,\"prev_change_id\":1,\"bids\":[[\"new\"," +
+                          number + "," + number + "]],\"asks\":[[\"delete\"," + number + ",0.0]]}";
+    BookUpdate update;
+    bool decoded = BookDecoder::decode_book(payload, update) && update.bids.size() == 1 && update.asks.size() == 1;
+    CHECK(decoded);
+    if (!decoded) {
+        std::cerr << "  book payload with " << number << " did not decode" << std::endl;
+        return;
+    }
+
+    uint64_t expected = bits(nlohmann_value(number));
+    bool same = bits(update.bids.prices[0]) == expected && bits(update.bids.amounts[0]) == expected &&
+                bits(update.asks.prices[0]) == expected;
+    CHECK(same);
+    if (!same) {
+        std::cerr << "  " << number << ": decoded bits " << std::hex << bits(update.bids.prices[0])
+                  << ", nlohmann bits " << expected << std::dec << std::endl;
+    }
+}
+
+static void check_trades(const std::string& number) {
+    std::string payload = "[{\"trade_seq\":7,\"timestamp\":1700000000000,\"price\":" + number +
+                          ",\"amount\":" + number + ",\"direction\":\"sell\"}]";
+    TradeBuffer trades;
+    bool decoded = BookDecoder::decode_trades(payload, trades) && trades.size() == 1;
+    CHECK(decoded);
+    if (!decoded) {
+        std::cerr << "  trades payload with " << number << " did not decode" << std::endl;
+        return;
+    }
+
+    uint64_t expected = bits(nlohmann_value(number));
+    bool same = bits(trades.prices[0]) == expected && bits(trades.amounts[0]) == expected;
+    CHECK(same);
+    if (!same) {
+        std::cerr << "  " << number << ": decoded trade bits " << std::hex << bits(trades.prices[0])
+                  << ", nlohmann bits " << expected << std::dec << std::endl;
+    }
+}
+
+int main() {
+    bool has_simd = BookDecoder::simd_enabled();
+    for (bool simd : {false, true}) {
+        BookDecoder::set_simd_enabled(simd);
+        if (BookDecoder::simd_enabled() != simd) {
+            std::cout << "AVX2 not available; skipping the SIMD pass" << std::endl;
+            continue;
+        }
+        for (const char* number : kNumbers) {
+            check_book(number);
+            check_trades(number);
+        }
+        std::cout << (simd ? "SIMD" : "scalar") << " pass: " << std::size(kNumbers) << " numbers checked" << std::endl;
+    }
+    BookDecoder::set_simd_enabled(has_simd);
+
+    return check_failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+// Check.hpp
+
+#ifndef CHECK_HPP
+#define CHECK_HPP
+
+#include <iostream>
+
+// Minimal assertions for the test executables: failures are reported and
+// counted, and main returns non-zero if there were any so CTest sees the result
+inline int& check_failures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                                            \
+    do {                                                                                       \
+        if (!(cond)) {                                                                         \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+            ++check_failures();                                                                \
+        }                                                                                      \
+    } while (0)
+
+#endif // CHECK_HPP
@@ -0,0 +1,58 @@
+// ConflationBufferTest.cpp
+
+#include "ConflationBuffer.hpp"
+#include "Check.hpp"
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+typedef std::vector<std::pair<ChannelId, std::string>> Delivered;
+
+static Delivered drain(ConflationBuffer& buffer) {
+    Delivered delivered;
+    buffer.drain([&delivered](ChannelId channel, std::string_view data) {
+        delivered.emplace_back(channel, std::string(data));
+    });
+    return delivered;
+}
+
+static void test_latest_value() {
+    ConflationBuffer buffer;
+    buffer.update(3, "a1");
+    buffer.update(1, "b1");
+    buffer.update(3, "a2");
+    CHECK(buffer.conflated_count() == 1);
+    // In the order the slots first became dirty, with the newest value
+    CHECK((drain(buffer) == Delivered{{3, "a2"}, {1, "b1"}}));
+    CHECK(buffer.empty());
+    CHECK(drain(buffer).empty());
+}
+
+static void test_throwing_callback() {
+    ConflationBuffer buffer;
+    buffer.update(1, "a1");
+    buffer.update(2, "b1");
+    bool threw = false;
+    try {
+        buffer.drain([](ChannelId, std::string_view) { throw std::runtime_error("send failed"); });
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    // Nothing from the failed drain is delivered again
+    CHECK(buffer.empty());
+    CHECK(drain(buffer).empty());
+
+    // and the slots work as before
+    buffer.update(2, "b2");
+    buffer.update(1, "a2");
+    CHECK((drain(buffer) == Delivered{{2, "b2"}, {1, "a2"}}));
+}
+
+int main() {
+    test_latest_value();
+    test_throwing_callback();
+
+    return check_failures() == 0 ? 0 : 1;
+}
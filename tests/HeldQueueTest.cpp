@@ -0,0 +1,84 @@
+// HeldQueueTest.cpp
+
+#include "HeldQueue.hpp"
+#include "Check.hpp"
+#include <string>
+#include <vector>
+
+typedef HeldQueue<std::string> Queue;
+
+static std::vector<std::string> drain(Queue& queue) {
+    std::vector<std::string> frames;
+    while (!queue.empty()) {
+        frames.push_back(queue.front());
+        queue.pop_front();
+    }
+    return frames;
+}
+
+static const ChannelId kBook = 1;   // Incremental book of an instrument
+static const ChannelId kTrades = 2; // Trades of the same instrument
+static const ChannelId kTicker = 3; // Ticker of the same instrument
+static const ChannelId kQuote = 4;
+
+static void test_drop_oldest() {
+    Queue queue(3, SlowConsumerPolicy::DropOldest);
+    CHECK(queue.push(kTicker, true, "t1") == Queue::Result::Queued);
+    CHECK(queue.push(kTicker, true, "t2") == Queue::Result::Queued);
+    CHECK(queue.push(kBook, false, "b1") == Queue::Result::Queued);
+    CHECK(queue.push(kBook, false, "b2") == Queue::Result::DroppedOldest);
+    CHECK(queue.size() == 3);
+    CHECK((drain(queue) == std::vector<std::string>{"t2", "b1", "b2"}));
+}
+
+static void test_conflate_only_snapshots() {
+    Queue queue(8, SlowConsumerPolicy::Conflate);
+    CHECK(queue.push(kBook, false, "b1") == Queue::Result::Queued);
+    CHECK(queue.push(kTicker, true, "t1") == Queue::Result::Queued);
+    CHECK(queue.push(kTrades, false, "tr1") == Queue::Result::Queued);
+    // Same instrument, different channel: the ticker must not replace a book increment or trade
+    CHECK(queue.push(kBook, false, "b2") == Queue::Result::Queued);
+    CHECK(queue.push(kTrades, false, "tr2") == Queue::Result::Queued);
+    CHECK(queue.push(kTicker, true, "t2") == Queue::Result::Conflated);
+    CHECK(queue.push(kQuote, true, "q1") == Queue::Result::Queued);
+    CHECK(queue.push(kTicker, true, "t3") == Queue::Result::Conflated);
+    // The newest ticker keeps the first one's place in the queue
+    CHECK((drain(queue) == std::vector<std::string>{"b1", "t3", "tr1", "b2", "tr2", "q1"}));
+
+    // Once sent, a channel starts a new entry
+    CHECK(queue.push(kTicker, true, "t4") == Queue::Result::Queued);
+    CHECK(queue.push(kTicker, true, "t5") == Queue::Result::Conflated);
+    CHECK((drain(queue) == std::vector<std::string>{"t5"}));
+}
+
+static void test_conflate_when_full() {
+    Queue queue(2, SlowConsumerPolicy::Conflate);
+    CHECK(queue.push(kTicker, true, "t1") == Queue::Result::Queued);
+    CHECK(queue.push(kBook, false, "b1") == Queue::Result::Queued);
+    CHECK(queue.push(kTicker, true, "t2") == Queue::Result::Conflated);
+    // Full: the oldest goes, and with it the ticker's entry
+    CHECK(queue.push(kBook, false, "b2") == Queue::Result::DroppedOldest);
+    CHECK(queue.push(kTicker, true, "t3") == Queue::Result::DroppedOldest);
+    CHECK(queue.push(kTicker, true, "t4") == Queue::Result::Conflated);
+    CHECK((drain(queue) == std::vector<std::string>{"b2", "t4"}));
+}
+
+static void test_disconnect() {
+    Queue queue(2, SlowConsumerPolicy::Disconnect);
+    CHECK(queue.push(kBook, false, "b1") == Queue::Result::Queued);
+    // Snapshot frames are only conflated under the Conflate policy
+    CHECK(queue.push(kTicker, true, "t1") == Queue::Result::Queued);
+    CHECK(queue.push(kTicker, true, "t2") == Queue::Result::Overflow);
+    CHECK(queue.size() == 2);
+    queue.clear();
+    CHECK(queue.empty());
+}
+
+int main() {
+    test_drop_oldest();
+    test_conflate_only_snapshots();
+    test_conflate_when_full();
+    test_disconnect();
+
+    return check_failures() == 0 ? 0 : 1;
+}
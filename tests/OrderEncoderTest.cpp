@@ -0,0 +1,136 @@
+// OrderEncoderTest.cpp
+
+#include "OrderEncoder.hpp"
+#include "Check.hpp"
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <nlohmann/json.hpp>
+
+// The request the generic path used to build and dump
+static std::string generic_request(uint64_t id, const std::string& method, const nlohmann::json& params) {
+    nlohmann::json request = {
+        {"jsonrpc", "2.0"},
+        {"id", id},
+        {"method", method},
+        {"params", params}
+    };
+    return request.dump();
+}
+
+static void check_same(std::string_view encoded, const std::string& expected) {
+    bool same = encoded == expected;
+    CHECK(same);
+    if (!same) {
+        std::cerr << "  encoded:  " << encoded << "\n  expected: " << expected << std::endl;
+    }
+}
+
+static void check_buy(uint64_t id, const std::string& instrument, const std::string& direction, double amount,
+                      double price, double tick_size) {
+    nlohmann::json params = {
+        {"instrument_name", instrument},
+        {"direction", direction},
+        {"amount", amount},
+        {"price", price}
+    };
+    check_same(OrderEncoder::encode_buy(id, instrument, direction, amount, price, tick_size),
+               generic_request(id, "private/buy", params));
+}
+
+static void check_edit(uint64_t id, const std::string& order_id, double amount, double price) {
+    nlohmann::json params = {
+        {"order_id", order_id},
+        {"amount", amount},
+        {"price", price}
+    };
+    check_same(OrderEncoder::encode_edit(id, order_id, amount, price), generic_request(id, "private/edit", params));
+}
+
+static void check_cancel(uint64_t id, const std::string& order_id) {
+    nlohmann::json params = {
+        {"order_id", order_id}
+    };
+    check_same(OrderEncoder::encode_cancel(id, order_id), generic_request(id, "private/cancel", params));
+}
+
+static void check_number(double value) {
+    std::string encoded;
+    OrderEncoder::append_double(encoded, value);
+    check_same(encoded, nlohmann::json(value).dump());
+}
+
+int main() {
+    // Representative orders, with and without a known tick size
+    check_buy(1, "BTC-PERPETUAL", "buy", 10.0, 65000.5, 0.5);
+    check_buy(2, "BTC-PERPETUAL", "sell", 250.0, 64999.0, 0.5);
+    check_buy(3, "ETH-PERPETUAL", "buy", 1.0, 3456.75, 0.05);
+    check_buy(4, "ETH-27DEC24-4000-C", "buy", 0.1, 0.0125, 0.0005);
+    check_buy(5, "BTC-27DEC24-100000-P", "sell", 2.5, 0.1, 0.0001);
+    check_buy(6, "SOL_USDC", "buy", 3.0, 145.123, 0.0);
+    check_buy(7, "BTC-PERPETUAL", "buy", 10.0, 65000.5, 0.0);
+    check_buy(UINT64_MAX, "BTC-PERPETUAL", "buy", 1e-5, 1e15, 0.0);
+    check_edit(8, "ETH-1234567", 20.0, 3500.0);
+    check_edit(9, "BTC-987654321", 0.3, 0.1 + 0.2);
+    check_cancel(10, "ETH-1234567");
+    check_cancel(11, "needs \"escaping\"\n");
+
+    // Number layout at the fixed/exponent boundaries and special values
+    for (double value : {0.0, -0.0, 1.0, -1.0, 100.0, 0.5, 0.1, 0.0001, 0.00001, 0.000123, 1e14, 1e15, 1e16,
+                         123456789012345.0, 1234567890123456.0, 1.5e300, -2.5e-300, 5e-324, 1.7976931348623157e308,
+                         0.30000000000000004}) {
+        check_number(value);
+    }
+
+    // Prices on common tick grids (the double nearest each grid decimal), with
+    // and without the tick size: both must print exactly what nlohmann prints
+    std::mt19937_64 rng(42);
+    const struct { int64_t units; double scale; } kTicks[] = {{5, 10.0}, {5, 100.0}, {5, 10000.0}, {1, 10000.0},
+                                                              {1, 1.0}, {1, 100.0}};
+    for (const auto& tick : kTicks) {
+        double tick_size = static_cast<double>(tick.units) / tick.scale;
+        std::uniform_int_distribution<int64_t> ticks(1, 20000000);
+        for (int i = 0; i < 20000; ++i) {
+            double price = static_cast<double>(ticks(rng) * tick.units) / tick.scale;
+            std::string on_tick;
+            std::string generic;
+            OrderEncoder::append_double(on_tick, price, tick_size);
+            OrderEncoder::append_double(generic, price);
+            std::string expected = nlohmann::json(price).dump();
+            bool same = on_tick == expected && generic == expected;
+            CHECK(same);
+            if (!same) {
+                std::cerr << "  tick " << tick_size << ": " << on_tick << " / " << generic << " vs " << expected
+                          << std::endl;
+                break;
+            }
+        }
+    }
+
+    // Any other double, including ones that need 16-17 significant digits
+    // (7762.6500000000005), must print exactly as nlohmann prints it
+    size_t differing = 0;
+    std::uniform_int_distribution<uint64_t> any_bits;
+    std::uniform_int_distribution<int64_t> short_mantissa(1, 999999999999999LL);
+    std::uniform_int_distribution<int> short_exponent(-20, 20);
+    for (int i = 0; i < 200000; ++i) {
+        uint64_t bits = any_bits(rng) & 0x7fefffffffffffffULL; // Finite
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        double off_grid = static_cast<double>(i) * 0.05;
+        double short_decimal = static_cast<double>(short_mantissa(rng)) * std::pow(10.0, short_exponent(rng));
+        for (double number : {value, -value, off_grid, short_decimal}) {
+            std::string encoded;
+            OrderEncoder::append_double(encoded, number);
+            std::string generic = nlohmann::json(number).dump();
+            if (encoded != generic && ++differing <= 5) {
+                std::cerr << "  " << encoded << " vs " << generic << std::endl;
+            }
+        }
+    }
+    CHECK(differing == 0);
+
+    return check_failures() == 0 ? 0 : 1;
+}
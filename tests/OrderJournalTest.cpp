@@ -0,0 +1,124 @@
+// OrderJournalTest.cpp
+
+#include "OrderJournal.hpp"
+#include "Check.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+static const char* const kPath = "order_journal_test.bin";
+
+static OrderJournal::Record open_record(int n) {
+    auto record = OrderJournal::make_record(OrderJournal::RecordType::Open, "ORDER-" + std::to_string(n),
+                                            "BTC-PERPETUAL", n % 2 ? "sell" : "buy", 10.0 * n, 65000.5 + n, 1.0);
+    record.intent_id = n;
+    return record;
+}
+
+static std::vector<OrderJournal::Record> replay(const OrderJournal& journal) {
+    std::vector<OrderJournal::Record> records;
+    journal.replay([&records](const OrderJournal::Record& record) { records.push_back(record); });
+    return records;
+}
+
+static void test_append_and_reopen() {
+    {
+        OrderJournal journal(kPath, 8);
+        CHECK(journal.is_open());
+        CHECK(journal.size() == 0);
+        for (int i = 1; i <= 3; ++i) {
+            CHECK(journal.append(open_record(i)));
+        }
+    }
+
+    OrderJournal journal(kPath, 8);
+    auto records = replay(journal);
+    CHECK(records.size() == 3);
+    for (size_t i = 0; i < records.size(); ++i) {
+        CHECK(records[i].sequence == i + 1);
+        CHECK(records[i].intent_id == i + 1);
+        CHECK(std::string(records[i].order_id) == "ORDER-" + std::to_string(i + 1));
+        CHECK(records[i].is_sell == (i + 1) % 2);
+        CHECK(records[i].price == 65000.5 + static_cast<double>(i + 1));
+    }
+}
+
+static void test_full_and_rewrite() {
+    OrderJournal journal(kPath, 4);
+    for (int i = 1; i <= 4; ++i) {
+        CHECK(journal.append(open_record(i)));
+    }
+    CHECK(!journal.append(open_record(5)));
+
+    // Compacting to fewer live records than half the capacity keeps the capacity
+    CHECK(journal.rewrite({open_record(2)}));
+    CHECK(journal.capacity() == 4);
+    CHECK(journal.size() == 1);
+    CHECK(journal.append(open_record(6)));
+    auto records = replay(journal);
+    CHECK(records.size() == 2);
+    CHECK(std::string(records[0].order_id) == "ORDER-2");
+    CHECK(std::string(records[1].order_id) == "ORDER-6");
+}
+
+static void test_rewrite_grows() {
+    std::vector<OrderJournal::Record> live;
+    for (int i = 1; i <= 4; ++i) {
+        live.push_back(open_record(i));
+    }
+    {
+        OrderJournal journal(kPath, 4);
+        // As many live orders as the capacity: the rewrite must leave room to append
+        CHECK(journal.rewrite(live));
+        CHECK(journal.capacity() == 8);
+        CHECK(journal.size() == 4);
+        for (int i = 5; i <= 8; ++i) {
+            CHECK(journal.append(open_record(i)));
+        }
+    }
+
+    // Reopened with the configured capacity, the grown file keeps all its records
+    OrderJournal journal(kPath, 4);
+    CHECK(journal.capacity() == 8);
+    CHECK(replay(journal).size() == 8);
+}
+
+static void test_torn_record_ends_replay() {
+    {
+        OrderJournal journal(kPath, 8);
+        CHECK(journal.rewrite({}));
+        CHECK(journal.append(open_record(1)));
+        CHECK(journal.append(open_record(2)));
+    }
+
+    // Clear the second record's sequence, as a crash before its commit would leave it
+    {
+        FILE* file = std::fopen(kPath, "r+b");
+        CHECK(file != nullptr);
+        uint64_t zero = 0;
+        std::fseek(file, static_cast<long>(2 * sizeof(OrderJournal::Record)), SEEK_SET);
+        std::fwrite(&zero, sizeof(zero), 1, file);
+        std::fclose(file);
+    }
+
+    OrderJournal journal(kPath, 8);
+    auto records = replay(journal);
+    CHECK(records.size() == 1);
+    CHECK(journal.append(open_record(3)));
+    CHECK(replay(journal).size() == 2);
+}
+
+int main() {
+    ::unlink(kPath);
+    test_append_and_reopen();
+    ::unlink(kPath);
+    test_full_and_rewrite();
+    ::unlink(kPath);
+    test_rewrite_grows();
+    ::unlink(kPath);
+    test_torn_record_ends_replay();
+    ::unlink(kPath);
+
+    return check_failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+// OrderTableTest.cpp
+
+#include "OrderTable.hpp"
+#include "Check.hpp"
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+static const char* const kPath = "order_table_test.bin";
+
+static std::vector<OrderJournal::Record> journal_records() {
+    OrderJournal journal(kPath, 4);
+    std::vector<OrderJournal::Record> records;
+    journal.replay([&records](const OrderJournal::Record& record) { records.push_back(record); });
+    return records;
+}
+
+static nlohmann::json order_update(const std::string& order_id, const std::string& state, double amount, double price,
+                                   double filled = 0.0) {
+    return {{"order_id", order_id}, {"order_state", state}, {"instrument_name", "BTC-PERPETUAL"},
+            {"direction", "buy"}, {"amount", amount}, {"price", price}, {"filled_amount", filled}};
+}
+
+static void test_snapshot_publication() {
+    OrderTable table;
+    auto empty = table.snapshot();
+    CHECK(empty && empty->empty());
+
+    CHECK(table.settle_intent(0, "ORDER-1", "BTC-PERPETUAL", "buy", 10.0, 65000.0));
+    CHECK(table.settle_intent(0, "ORDER-2", "ETH-PERPETUAL", "sell", 5.0, 3000.0));
+    // Nothing is visible before publish
+    CHECK(table.snapshot()->empty());
+    table.publish();
+    auto first = table.snapshot();
+    CHECK(first->size() == 2);
+
+    CHECK(table.modify("ORDER-1", 20.0, 64000.0));
+    CHECK(table.remove("ORDER-2"));
+    table.publish();
+    auto second = table.snapshot();
+    CHECK(second->size() == 1);
+    CHECK((*second)[0].order_id == "ORDER-1" && (*second)[0].quantity == 20.0 && (*second)[0].price == 64000.0);
+    // A reader holding the earlier snapshot still sees it unchanged
+    CHECK(first->size() == 2);
+    CHECK((*first)[0].quantity == 10.0);
+
+    // The vacated slot is reused
+    CHECK(table.settle_intent(0, "ORDER-3", "BTC-PERPETUAL", "sell", 1.0, 66000.0));
+    table.publish();
+    CHECK(table.snapshot()->size() == 2);
+    CHECK((table.order_ids("BTC-PERPETUAL") == std::vector<std::string>{"ORDER-1", "ORDER-3"}));
+}
+
+static void test_late_responses() {
+    OrderTable table;
+    CHECK(table.settle_intent(0, "ORDER-1", "BTC-PERPETUAL", "buy", 10.0, 65000.0));
+    table.apply_order_update(order_update("ORDER-1", "cancelled", 10.0, 65000.0));
+    CHECK(!table.contains("ORDER-1"));
+
+    // A modify or place response that arrives after the close must not revive the order
+    CHECK(!table.modify("ORDER-1", 20.0, 64000.0));
+    CHECK(!table.settle_intent(0, "ORDER-1", "BTC-PERPETUAL", "buy", 10.0, 65000.0));
+    table.apply_order_update(order_update("ORDER-1", "open", 10.0, 65000.0));
+    table.publish();
+    CHECK(table.snapshot()->empty());
+    // Nor may a second close
+    CHECK(!table.remove("ORDER-1"));
+}
+
+static void test_notifications_before_ack() {
+    OrderTable table;
+    // user.orders reports the order before the place response
+    table.apply_order_update(order_update("ORDER-1", "open", 10.0, 65000.0, 2.0));
+    CHECK(table.settle_intent(0, "ORDER-1", "BTC-PERPETUAL", "buy", 10.0, 65000.0));
+    table.publish();
+    CHECK(table.snapshot()->size() == 1);
+    CHECK((*table.snapshot())[0].filled_quantity == 2.0);
+
+    // A partial fill from user.trades, then a stale user.orders fill: the larger one wins
+    table.apply_trade({{"order_id", "ORDER-1"}, {"state", "open"}, {"amount", 5.0}});
+    table.apply_order_update(order_update("ORDER-1", "open", 10.0, 65000.0, 2.0));
+    table.publish();
+    CHECK((*table.snapshot())[0].filled_quantity == 5.0);
+
+    // Filled before the response: the order is closed and the response is dropped
+    table.apply_trade({{"order_id", "ORDER-2"}, {"state", "filled"}, {"amount", 1.0}});
+    CHECK(!table.settle_intent(0, "ORDER-2", "BTC-PERPETUAL", "sell", 1.0, 64000.0));
+    // Cancelled before the response
+    table.apply_order_update(order_update("ORDER-3", "cancelled", 3.0, 63000.0));
+    CHECK(!table.settle_intent(0, "ORDER-3", "BTC-PERPETUAL", "buy", 3.0, 63000.0));
+    table.publish();
+    CHECK(table.snapshot()->size() == 1);
+    CHECK(table.size() == 1);
+}
+
+static void test_compaction_keeps_intents() {
+    uint64_t in_flight = 0;
+    uint64_t failing = 0;
+    {
+        OrderTable table(kPath, 4);
+        in_flight = table.record_intent("BTC-PERPETUAL", "buy", 10.0, 65000.0);
+        uint64_t placed = table.record_intent("BTC-PERPETUAL", "sell", 20.0, 66000.0);
+        CHECK(table.settle_intent(placed, "ORDER-1", "BTC-PERPETUAL", "sell", 20.0, 66000.0));
+        table.publish();
+        failing = table.record_intent("ETH-PERPETUAL", "buy", 1.0, 3000.0);
+        // The journal is full: this intent compacts it, and both open intents must survive
+        uint64_t last = table.record_intent("ETH-PERPETUAL", "sell", 2.0, 3100.0);
+        CHECK(table.unacknowledged_intents() == 3);
+        CHECK(table.settle_intent(last, "ORDER-2", "ETH-PERPETUAL", "sell", 2.0, 3100.0));
+        table.publish();
+    }
+
+    auto records = journal_records();
+    // Compacted to the three intents and ORDER-1, then ORDER-2's acknowledgement
+    CHECK(records.size() == 5);
+    CHECK(records[0].type == OrderJournal::RecordType::Intent && records[0].intent_id == in_flight);
+    CHECK(records[1].type == OrderJournal::RecordType::Intent && records[1].intent_id == failing);
+    CHECK(records[2].type == OrderJournal::RecordType::Intent);
+    CHECK(records[3].type == OrderJournal::RecordType::Open && std::string(records[3].order_id) == "ORDER-1");
+    CHECK(records[4].type == OrderJournal::RecordType::Open && records[4].intent_id == records[2].intent_id);
+
+    // Replayed: the unanswered intents are still open, the answered ones are not
+    {
+        OrderTable table(kPath, 4);
+        CHECK(table.size() == 2);
+        CHECK(table.unacknowledged_intents() == 2);
+        // A failed place settles its intent with a Closed record
+        CHECK(!table.settle_intent(failing, "", "ETH-PERPETUAL", "buy", 1.0, 3000.0));
+        CHECK(table.unacknowledged_intents() == 1);
+        // Compacting at startup keeps the remaining one
+        table.checkpoint();
+    }
+    OrderTable table(kPath, 4);
+    CHECK(table.unacknowledged_intents() == 1);
+    CHECK(table.size() == 2);
+    // Intent ids continue after the replayed ones
+    CHECK(table.record_intent("BTC-PERPETUAL", "buy", 1.0, 64000.0) > in_flight);
+}
+
+int main() {
+    test_snapshot_publication();
+    test_late_responses();
+    test_notifications_before_ack();
+
+    ::unlink(kPath);
+    test_compaction_keeps_intents();
+    ::unlink(kPath);
+
+    return check_failures() == 0 ? 0 : 1;
+}
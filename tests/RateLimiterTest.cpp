@@ -0,0 +1,132 @@
+// RateLimiterTest.cpp
+
+#include "RateLimiter.hpp"
+#include "Check.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef RateLimiter::Pool Pool;
+typedef RateLimiter::Priority Priority;
+
+// Tasks released by the governor thread, in the order they ran
+struct Released {
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<std::string> names;
+    std::vector<bool> admitted;
+
+    RateLimiter::Task task(const std::string& name) {
+        return [this, name](bool ok) {
+            std::lock_guard<std::mutex> lock(mtx);
+            names.push_back(name);
+            admitted.push_back(ok);
+            cv.notify_all();
+        };
+    }
+
+    bool wait_for(size_t count) {
+        std::unique_lock<std::mutex> lock(mtx);
+        return cv.wait_for(lock, std::chrono::seconds(5), [this, count] { return names.size() >= count; });
+    }
+};
+
+static void test_burst_and_refill() {
+    RateLimiter limiter({10.0, 3.0}, {10.0, 3.0}, 0.0, 1000);
+    for (int i = 0; i < 3; ++i) {
+        CHECK(limiter.try_acquire(Pool::MatchingEngine, Priority::Normal));
+    }
+    CHECK(!limiter.try_acquire(Pool::MatchingEngine, Priority::Normal));
+    // The other pool has its own bucket
+    CHECK(limiter.try_acquire(Pool::NonMatching, Priority::Normal));
+
+    // Long enough to refill five credits, but the bucket holds only the burst
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    for (int i = 0; i < 3; ++i) {
+        CHECK(limiter.try_acquire(Pool::MatchingEngine, Priority::Normal));
+    }
+    CHECK(!limiter.try_acquire(Pool::MatchingEngine, Priority::Normal));
+    CHECK(limiter.get_stats().immediate == 7);
+}
+
+static void test_cancels_jump_queue() {
+    Released released;
+    RateLimiter limiter({10.0, 1.0}, {10.0, 1.0}, 0.0, 5000);
+    CHECK(limiter.try_acquire(Pool::MatchingEngine, Priority::Normal));
+    limiter.submit(Pool::MatchingEngine, Priority::Normal, released.task("order-1"));
+    limiter.submit(Pool::MatchingEngine, Priority::Normal, released.task("order-2"));
+    limiter.submit(Pool::MatchingEngine, Priority::Cancel, released.task("cancel"));
+    // Nothing may overtake the queue, not even a cancel with try_acquire
+    CHECK(!limiter.try_acquire(Pool::MatchingEngine, Priority::Cancel));
+
+    CHECK(released.wait_for(3));
+    CHECK((released.names == std::vector<std::string>{"cancel", "order-1", "order-2"}));
+    CHECK((released.admitted == std::vector<bool>{true, true, true}));
+    CHECK(limiter.get_stats().queued == 3);
+}
+
+static void test_cancel_reserve() {
+    // Slow enough that nothing refills during the test
+    RateLimiter limiter({0.01, 3.0}, {10.0, 1.0}, 2.0, 1000);
+    CHECK(limiter.try_acquire(Pool::MatchingEngine, Priority::Normal));
+    // Two credits left, both reserved for cancels
+    CHECK(!limiter.try_acquire(Pool::MatchingEngine, Priority::Normal));
+    CHECK(limiter.try_acquire(Pool::MatchingEngine, Priority::Cancel));
+    CHECK(limiter.try_acquire(Pool::MatchingEngine, Priority::Cancel));
+    CHECK(!limiter.try_acquire(Pool::MatchingEngine, Priority::Cancel));
+
+    // The reserve is clamped so that new orders keep at least one credit
+    RateLimiter clamped({0.01, 2.0}, {10.0, 1.0}, 5.0, 1000);
+    CHECK(clamped.try_acquire(Pool::MatchingEngine, Priority::Normal));
+    CHECK(!clamped.try_acquire(Pool::MatchingEngine, Priority::Normal));
+    CHECK(clamped.try_acquire(Pool::MatchingEngine, Priority::Cancel));
+}
+
+static void test_shed_beyond_max_queue() {
+    Released released;
+    RateLimiter limiter({10.0, 1.0}, {10.0, 1.0}, 0.0, 250);
+    CHECK(limiter.try_acquire(Pool::MatchingEngine, Priority::Normal));
+    // About 100 and 200 ms of waiting: queued
+    limiter.submit(Pool::MatchingEngine, Priority::Normal, released.task("order-1"));
+    limiter.submit(Pool::MatchingEngine, Priority::Normal, released.task("order-2"));
+    // About 300 ms: shed at once, on this thread
+    bool shed_admitted = true;
+    limiter.submit(Pool::MatchingEngine, Priority::Normal, [&shed_admitted](bool ok) { shed_admitted = ok; });
+    CHECK(!shed_admitted);
+    CHECK(limiter.get_stats().shed == 1);
+    // Cancels are never shed
+    limiter.submit(Pool::MatchingEngine, Priority::Cancel, released.task("cancel"));
+    CHECK(limiter.get_stats().shed == 1);
+
+    CHECK(released.wait_for(3));
+    CHECK((released.names == std::vector<std::string>{"cancel", "order-1", "order-2"}));
+    CHECK((released.admitted == std::vector<bool>{true, true, true}));
+}
+
+static void test_throttled_and_stop() {
+    Released released;
+    {
+        RateLimiter limiter({0.01, 5.0}, {10.0, 1.0}, 0.0, 1000000);
+        // too_many_requests from the exchange empties the bucket
+        limiter.on_throttled(Pool::MatchingEngine);
+        CHECK(!limiter.try_acquire(Pool::MatchingEngine, Priority::Normal));
+        CHECK(limiter.get_stats().throttled == 1);
+        limiter.submit(Pool::MatchingEngine, Priority::Normal, released.task("order"));
+    }
+    // Still queued when the limiter stopped
+    CHECK((released.names == std::vector<std::string>{"order"}));
+    CHECK((released.admitted == std::vector<bool>{false}));
+}
+
+int main() {
+    test_burst_and_refill();
+    test_cancels_jump_queue();
+    test_cancel_reserve();
+    test_shed_beyond_max_queue();
+    test_throttled_and_stop();
+
+    return check_failures() == 0 ? 0 : 1;
+}
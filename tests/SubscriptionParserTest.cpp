@@ -0,0 +1,32 @@
+// SubscriptionParserTest.cpp
+
+#include "SubscriptionParser.hpp"
+#include "Check.hpp"
+
+static void test_parse() {
+    SubscriptionView view;
+    CHECK(SubscriptionParser::parse(
+        R"({"jsonrpc":"2.0","method":"subscription","params":{"channel":"ticker.BTC-PERPETUAL.raw","data":{"a":1}}})",
+        view));
+    CHECK(view.channel == "ticker.BTC-PERPETUAL.raw");
+    CHECK(view.data == R"({"a":1})");
+    CHECK(!SubscriptionParser::parse(R"({"jsonrpc":"2.0","id":7,"result":[]})", view));
+}
+
+static void test_is_response() {
+    CHECK(SubscriptionParser::is_response(R"({"jsonrpc":"2.0","id":7,"result":["book.BTC-PERPETUAL.raw"]})"));
+    CHECK(SubscriptionParser::is_response(R"( { "jsonrpc" : "2.0" , "id" : 8 , "error" : {"code":10028}})"));
+    CHECK(SubscriptionParser::is_response(R"({"result":{"access_token":"x"},"id":9})"));
+    CHECK(!SubscriptionParser::is_response(
+        R"({"jsonrpc":"2.0","method":"subscription","params":{"channel":"trades.BTC-PERPETUAL.raw","data":[]}})"));
+    CHECK(!SubscriptionParser::is_response(R"({"jsonrpc":"2.0","method":"heartbeat","params":{"type":"test_request"}})"));
+    CHECK(!SubscriptionParser::is_response("not json"));
+    CHECK(!SubscriptionParser::is_response("{}"));
+}
+
+int main() {
+    test_parse();
+    test_is_response();
+
+    return check_failures() == 0 ? 0 : 1;
+}